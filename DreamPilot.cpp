@@ -1,10 +1,12 @@
 #include <esp_log.h>
 #include <iostream>
+#include <nvs_flash.h>
 
 #include <sdkconfig.h>
 
 #include "modules/GPS/IGPSModule.h"
 #include "modules/GPS/NEO6M.h"
+#include "modules/UART/ESPUARTPort.h"
 
 #include "modules/IMU/IIMUModule.h"
 #include "modules/IMU/MPU6050.h"
@@ -20,7 +22,16 @@ extern "C" void app_main(void)
     ESP_LOGI(TAG, "Starting DreamPilot v0.0.1");
     std::cout << "Hello, World!" << std::endl;
 
-    IGPSModule *gps = new NEO6M();
+    // IMU calibration is kept in NVS
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND)
+    {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        ret = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK(ret);
+
+    IGPSModule *gps = new NEO6M(new ESPUARTPort());
     gps->start();
 
     IIMUModule *imu = new MPU6050();
@@ -0,0 +1,60 @@
+//
+// Created by stikper on 09.06.25.
+//
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+
+// Latest value of a struct shared by one writer task with any number of readers, without locks.
+// The writer fills the buffer readers are not using and then publishes it by bumping the sequence,
+// so a reader always copies a complete value and never waits for a writer that was preempted halfway.
+// A reader retries only if a whole new value was published during its copy.
+template <typename T>
+class Snapshot
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Snapshot copies the value as plain memory");
+
+    T buffers[2];
+    std::atomic<uint32_t> sequence; // Values published, the current one is buffers[sequence % 2]
+
+public:
+    Snapshot() : buffers{}
+    {
+        sequence.store(0, std::memory_order_relaxed);
+    }
+
+    // Writer only
+    void store(const T& value)
+    {
+        const uint32_t n = sequence.load(std::memory_order_relaxed);
+        // Readers of the previous publication may still be copying this buffer, they detect it by the sequence
+        std::atomic_thread_fence(std::memory_order_release);
+        buffers[(n + 1) % 2] = value;
+        sequence.store(n + 1, std::memory_order_release);
+    }
+
+    T load() const
+    {
+        while (true)
+        {
+            const uint32_t n = sequence.load(std::memory_order_acquire);
+            T value = buffers[n % 2];
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == n) return value;
+        }
+    }
+
+    // Writer only: the value it published last
+    const T& current() const
+    {
+        return buffers[sequence.load(std::memory_order_relaxed) % 2];
+    }
+};
+
+
+#endif //SNAPSHOT_H
@@ -0,0 +1,143 @@
+//
+// Created by stikper on 14.05.25.
+//
+
+#include "FixHistory.h"
+
+
+namespace
+{
+    constexpr int64_t HALF_TURN_E7 = 1800000000;
+    constexpr int64_t DAY_MS = 86400000;
+
+    // Angle difference b - a wrapped to the shorter way around
+    int64_t wrappedDelta(const int32_t a, const int32_t b)
+    {
+        int64_t delta = static_cast<int64_t>(b) - a;
+        if (delta > HALF_TURN_E7) delta -= 2 * HALF_TURN_E7;
+        if (delta < -HALF_TURN_E7) delta += 2 * HALF_TURN_E7;
+        return delta;
+    }
+
+    int32_t wrapLongitude(int64_t lon)
+    {
+        if (lon > HALF_TURN_E7) lon -= 2 * HALF_TURN_E7;
+        if (lon < -HALF_TURN_E7) lon += 2 * HALF_TURN_E7;
+        return static_cast<int32_t>(lon);
+    }
+
+    float lerpHeading(const float a, const float b, const float k)
+    {
+        float delta = b - a;
+        if (delta > 180.0f) delta -= 360.0f;
+        if (delta < -180.0f) delta += 360.0f;
+        float result = a + delta * k;
+        if (result < 0.0f) result += 360.0f;
+        if (result >= 360.0f) result -= 360.0f;
+        return result;
+    }
+}
+
+FixHistory::FixHistory()
+{
+    pushed.store(0, std::memory_order_relaxed);
+    cleared.store(0, std::memory_order_relaxed);
+}
+
+const FixHistory::Sample& FixHistory::get(const uint32_t index) const
+{
+    return samples[index % SLOTS];
+}
+
+void FixHistory::push(const Sample& sample)
+{
+    const uint32_t end = pushed.load(std::memory_order_relaxed);
+    if (end != cleared.load(std::memory_order_relaxed) && sample.time <= get(end - 1).time) return;
+
+    // Readers of the previous publication do not include this slot, a reader that started earlier retries
+    std::atomic_thread_fence(std::memory_order_release);
+    samples[end % SLOTS] = sample;
+    pushed.store(end + 1, std::memory_order_release);
+}
+
+void FixHistory::clear()
+{
+    cleared.store(pushed.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+size_t FixHistory::size() const
+{
+    const uint32_t end = pushed.load(std::memory_order_acquire);
+    const auto count = static_cast<int32_t>(end - cleared.load(std::memory_order_acquire));
+    if (count < 0) return 0;
+    return static_cast<size_t>(count) < CAPACITY ? count : CAPACITY;
+}
+
+void FixHistory::interpolate(const Sample& a, const Sample& b, const int64_t time, Sample* result)
+{
+    // k > 1 extrapolates past b
+    const int64_t span = b.time - a.time;
+    const int64_t elapsed = time - a.time;
+    const float k = static_cast<float>(elapsed) / static_cast<float>(span);
+
+    result->time = time;
+    result->content = a.content & b.content;
+    result->time_ms = static_cast<int32_t>((a.time_ms + elapsed / 1000) % DAY_MS); // Across 00:00 UTC
+    result->lat_e7 = static_cast<int32_t>(a.lat_e7 + (static_cast<int64_t>(b.lat_e7) - a.lat_e7) * elapsed / span);
+    result->lon_e7 = wrapLongitude(a.lon_e7 + wrappedDelta(a.lon_e7, b.lon_e7) * elapsed / span);
+    result->alt = a.alt + (b.alt - a.alt) * k;
+    result->spd = a.spd + (b.spd - a.spd) * k;
+    result->hdg = lerpHeading(a.hdg, b.hdg, k);
+}
+
+bool FixHistory::at(const int64_t time, Sample* result) const
+{
+    Sample a, b;
+    bool found, single;
+    while (true)
+    {
+        const uint32_t end = pushed.load(std::memory_order_acquire);
+        const auto count = static_cast<int32_t>(end - cleared.load(std::memory_order_acquire));
+        const uint32_t begin = count < 0 ? end : count > static_cast<int32_t>(CAPACITY) ? end - CAPACITY : end - count;
+
+        found = false;
+        single = false;
+        if (end != begin && time >= get(begin).time)
+        {
+            const Sample& newest = get(end - 1);
+            if (time >= newest.time)
+            {
+                if (time - newest.time <= MAX_EXTRAPOLATION_US)
+                {
+                    single = end - begin < 2;
+                    a = single ? newest : get(end - 2);
+                    b = newest;
+                    found = true;
+                }
+            }
+            else
+            {
+                // First sample newer than time, the one before it is not newer
+                uint32_t low = begin + 1, high = end - 1;
+                while (low != high)
+                {
+                    const uint32_t mid = low + (high - low) / 2;
+                    if (get(mid).time > time) high = mid;
+                    else low = mid + 1;
+                }
+                a = get(low - 1);
+                b = get(low);
+                found = true;
+            }
+        }
+
+        // A push during the lookup may have reused a slot it read
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (pushed.load(std::memory_order_relaxed) == end) break;
+    }
+
+    if (!found) return false;
+    if (single) *result = b;
+    else interpolate(a, b, time, result);
+    return true;
+}
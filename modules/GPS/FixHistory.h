@@ -0,0 +1,60 @@
+//
+// Created by stikper on 14.05.25.
+//
+
+#ifndef FIXHISTORY_H
+#define FIXHISTORY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <sdkconfig.h>
+
+
+// Ring of recent position fixes ordered by esp_timer time.
+// Lookups binary search the ring and interpolate between the neighbouring fixes,
+// or extrapolate from the last two for a short time after the newest one.
+// One writer task pushes, lookups run on any task without locks: a sample is published by the push count
+// after it is written, and a lookup that overlapped a push is repeated.
+class FixHistory
+{
+public:
+    static constexpr size_t CAPACITY = CONFIG_GPS_BUFFER_SIZE;
+    static constexpr int64_t MAX_EXTRAPOLATION_US = 1000000;
+
+    struct Sample
+    {
+        int64_t time = -1;   // esp_timer
+        uint8_t content = 0; // IGPSModule::content_t flags
+        int32_t time_ms = 0;
+        int32_t lat_e7 = 0;
+        int32_t lon_e7 = 0;
+        float alt = 0;
+        float spd = 0;
+        float hdg = 0;
+    };
+
+private:
+    static constexpr size_t SLOTS = CAPACITY + 1; // The one the writer is filling is never in a reader's window
+
+    Sample samples[SLOTS];
+    std::atomic<uint32_t> pushed;  // Samples published, sample i is in samples[i % SLOTS]
+    std::atomic<uint32_t> cleared; // First sample after the last clear()
+
+    const Sample& get(uint32_t index) const;
+    static void interpolate(const Sample& a, const Sample& b, int64_t time, Sample* result);
+
+public:
+    FixHistory();
+
+    // Writer only. Samples not newer than the last one are dropped
+    void push(const Sample& sample);
+    void clear();
+    size_t size() const;
+
+    // False if time is before the oldest sample or too far after the newest
+    bool at(int64_t time, Sample* result) const;
+};
+
+
+#endif //FIXHISTORY_H
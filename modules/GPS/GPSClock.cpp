@@ -0,0 +1,97 @@
+//
+// Created by stikper on 12.05.25.
+//
+
+#include "GPSClock.h"
+
+#include <esp_timer.h>
+
+
+int64_t GPSClock::project(const Model& m, const int64_t tick)
+{
+    const int64_t elapsed = tick - m.tick_ref;
+    return m.utc_ref + elapsed + elapsed * m.drift_ppb / 1000000000;
+}
+
+void GPSClock::update(const int64_t tick, const int64_t utc_us, const bool pps)
+{
+    Model m = model.current();
+    const int64_t residual = m.synced ? utc_us - project(m, tick) : 0;
+    const int64_t elapsed = tick - m.tick_ref;
+
+    if (!m.synced || m.pps != pps || residual > RESYNC_US || residual < -RESYNC_US || elapsed <= 0)
+    {
+        // First fix, time source change or a jump: take the measurement as is, keep the drift
+        m.synced = true;
+        m.pps = pps;
+        m.tick_ref = tick;
+        m.utc_ref = utc_us;
+        m.tick_base = tick;
+        m.utc_base = utc_us;
+        m.error_us = 0;
+        m.updates = 1;
+        model.store(m);
+        return;
+    }
+
+    // Pulse timed measurements are trusted, reception timed ones carry tens of ms of jitter
+    const int shift = pps ? 1 : 4;
+    m.utc_ref = project(m, tick) + residual / (1 << shift);
+    m.tick_ref = tick;
+
+    // Drift is measured over a long baseline, so the jitter of single measurements averages out
+    const int64_t baseline = tick - m.tick_base;
+    if (baseline >= MIN_BASELINE_US)
+    {
+        int64_t drift = ((utc_us - m.utc_base) - baseline) * 1000000000 / baseline;
+        if (drift > MAX_DRIFT_PPB) drift = MAX_DRIFT_PPB;
+        if (drift < -MAX_DRIFT_PPB) drift = -MAX_DRIFT_PPB;
+        m.drift_ppb += static_cast<int32_t>((drift - m.drift_ppb) / 8);
+    }
+    if (baseline >= MAX_BASELINE_US)
+    {
+        m.tick_base = m.tick_ref;
+        m.utc_base = m.utc_ref;
+    }
+
+    const int64_t error = residual < 0 ? -residual : residual;
+    m.error_us = static_cast<uint32_t>(m.error_us + (error - static_cast<int64_t>(m.error_us)) / 8);
+    m.updates++;
+
+    model.store(m);
+}
+
+void GPSClock::reset()
+{
+    model.store({});
+}
+
+int64_t GPSClock::toUtc(const int64_t tick) const
+{
+    const Model m = model.load();
+    return m.synced ? project(m, tick) : -1;
+}
+
+int64_t GPSClock::toTick(const int64_t utc_us) const
+{
+    const Model m = model.load();
+    if (!m.synced) return -1;
+
+    // Inverse of project(), drift is small enough for a single correction
+    const int64_t elapsed = utc_us - m.utc_ref;
+    return m.tick_ref + elapsed - elapsed * m.drift_ppb / 1000000000;
+}
+
+GPSClock::Quality GPSClock::getQuality() const
+{
+    const Model m = model.load();
+
+    Quality result = {};
+    result.synced = m.synced;
+    result.pps = m.pps;
+    result.age_us = m.synced ? esp_timer_get_time() - m.tick_ref : -1;
+    result.error_us = m.error_us;
+    result.drift_ppb = m.drift_ppb;
+    result.updates = m.updates;
+    return result;
+}
@@ -0,0 +1,85 @@
+//
+// Created by stikper on 12.05.25.
+//
+
+#ifndef GPSCLOCK_H
+#define GPSCLOCK_H
+
+#include <cstdint>
+
+#include "Common/Snapshot.h"
+
+
+// esp_timer <-> UTC mapping: offset and drift of the local oscillator, filtered over GPS fixes.
+// Conversions are a multiply-add on the last anchor, UTC is microseconds since the Unix epoch.
+// The model is published as a snapshot: conversions never block, update() and reset() belong to one writer task.
+class GPSClock
+{
+public:
+    struct Quality
+    {
+        bool synced = false;
+        bool pps = false;      // Anchored to the time pulse, otherwise to UART reception
+        int64_t age_us = -1;   // Since the last update
+        uint32_t error_us = 0; // Mean absolute residual of recent updates
+        int32_t drift_ppb = 0; // Local clock rate error
+        uint32_t updates = 0;
+    };
+
+private:
+    static constexpr int64_t RESYNC_US = 500000;     // Residual treated as a time jump
+    static constexpr int32_t MAX_DRIFT_PPB = 500000; // 500 ppm, far beyond any crystal
+    static constexpr int64_t MIN_BASELINE_US = 10000000;
+    static constexpr int64_t MAX_BASELINE_US = 3600000000; // Lets drift follow temperature
+
+    struct Model
+    {
+        bool synced = false;
+        bool pps = false;
+        int64_t tick_ref = 0; // esp_timer
+        int64_t utc_ref = 0;  // UTC at tick_ref
+        int64_t tick_base = 0; // Start of the drift baseline
+        int64_t utc_base = 0;
+        int32_t drift_ppb = 0;
+        uint32_t error_us = 0;
+        uint32_t updates = 0;
+    };
+
+    Snapshot<Model> model;
+
+    static int64_t project(const Model& m, int64_t tick);
+
+public:
+    // One measurement: UTC utc_us happened at esp_timer tick
+    void update(int64_t tick, int64_t utc_us, bool pps);
+    void reset();
+
+    // -1 only until the first update
+    int64_t toUtc(int64_t tick) const;
+    int64_t toTick(int64_t utc_us) const;
+    Quality getQuality() const;
+
+    // Days since 1970-01-01 of a proleptic Gregorian date
+    static constexpr int64_t daysFromCivil(int32_t year, const uint32_t month, const uint32_t day)
+    {
+        year -= month <= 2;
+        const int32_t era = (year >= 0 ? year : year - 399) / 400;
+        const uint32_t yoe = static_cast<uint32_t>(year - era * 400);
+        const uint32_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+        const uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return static_cast<int64_t>(era) * 146097 + doe - 719468;
+    }
+
+    static constexpr int64_t toUnixUs(const uint16_t year, const uint8_t month, const uint8_t day,
+                                      const int32_t time_ms)
+    {
+        return (daysFromCivil(year, month, day) * 86400000 + time_ms) * 1000;
+    }
+};
+
+static_assert(GPSClock::daysFromCivil(1970, 1, 1) == 0);
+static_assert(GPSClock::daysFromCivil(2000, 3, 1) == 11017);
+static_assert(GPSClock::toUnixUs(2025, 5, 12, 0) == 1747008000LL * 1000000);
+
+
+#endif //GPSCLOCK_H
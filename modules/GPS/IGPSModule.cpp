@@ -3,91 +3,249 @@
 //
 
 #include "IGPSModule.h"
+#include "PPSCapture.h"
 
+#include <cmath>
 #include <esp_log.h>
-#include <stdexcept>
 
 
 IGPSModule::IGPSModule()
 {
     TAG = "GPS";
 
-    lastPos.dataMutex = xSemaphoreCreateMutex();
-    lastVel.dataMutex = xSemaphoreCreateMutex();
-    lastAlt.dataMutex = xSemaphoreCreateMutex();
-    lastTime.dataMutex = xSemaphoreCreateMutex();
-    // TODO: Test throw error
-    if (lastPos.dataMutex == nullptr || lastVel.dataMutex == nullptr || lastAlt.dataMutex == nullptr ||
-        lastTime.dataMutex == nullptr)
-        throw std::runtime_error("Failed to create GPS data mutex");
+    pps = nullptr;
+    pendingKey = -1;
+    pendingSeen = 0;
+    epochContent = 0;
+    pendingPublished = false;
+    gsvTracked = 0;
+    gsvMaxSnr = 0;
 }
 
-IGPSModule::~IGPSModule()
+IGPSModule::~IGPSModule() = default;
+
+IGPSModule::Fix IGPSModule::getFix() const
 {
-    if (lastPos.dataMutex != nullptr)
-        vSemaphoreDelete(lastPos.dataMutex);
-    if (lastVel.dataMutex != nullptr)
-        vSemaphoreDelete(lastVel.dataMutex);
-    if (lastAlt.dataMutex != nullptr)
-        vSemaphoreDelete(lastAlt.dataMutex);
-    if (lastTime.dataMutex != nullptr)
-        vSemaphoreDelete(lastTime.dataMutex);
+    return lastFix.load();
 }
 
 IGPSModule::Position IGPSModule::getPos() const
 {
-    Position result = {};
-    result.valid = false;
-    if (xSemaphoreTake(lastPos.dataMutex, 100) == pdTRUE)
+    const Fix fix = getFix();
+    return {fix.timestamp, (fix.content & CONTENT_POS) != 0, fix.time_ms, fix.lat_e7, fix.lon_e7};
+}
+
+IGPSModule::Velocity IGPSModule::getVel() const
+{
+    const Fix fix = getFix();
+    return {fix.timestamp, (fix.content & CONTENT_VEL) != 0, fix.time_ms, fix.spd, fix.hdg};
+}
+
+IGPSModule::Altitude IGPSModule::getAlt() const
+{
+    const Fix fix = getFix();
+    return {fix.timestamp, (fix.content & CONTENT_ALT) != 0, fix.time_ms, fix.alt};
+}
+
+IGPSModule::TimeDate IGPSModule::getTime() const
+{
+    const Fix fix = getFix();
+    return {
+        fix.timestamp, (fix.content & CONTENT_TIME) && (fix.content & CONTENT_DATE), fix.time_ms,
+        fix.day, fix.month, fix.year
+    };
+}
+
+IGPSModule::Position IGPSModule::getPosAt(const int64_t time) const
+{
+    FixHistory::Sample sample;
+    if (!history.at(time, &sample)) return {};
+    return {sample.time, (sample.content & CONTENT_POS) != 0, sample.time_ms, sample.lat_e7, sample.lon_e7};
+}
+
+IGPSModule::Velocity IGPSModule::getVelAt(const int64_t time) const
+{
+    FixHistory::Sample sample;
+    if (!history.at(time, &sample)) return {};
+    return {sample.time, (sample.content & CONTENT_VEL) != 0, sample.time_ms, sample.spd, sample.hdg};
+}
+
+IGPSModule::Altitude IGPSModule::getAltAt(const int64_t time) const
+{
+    FixHistory::Sample sample;
+    if (!history.at(time, &sample)) return {};
+    return {sample.time, (sample.content & CONTENT_ALT) != 0, sample.time_ms, sample.alt};
+}
+
+IGPSModule::Quality IGPSModule::getQuality() const
+{
+    return lastQuality.load();
+}
+
+int64_t IGPSModule::epochKey(const GPSData& newData)
+{
+    // UBX NAV messages of one solution share iTOW, NMEA sentences share UTC time
+    if (newData.type == NMEAType::UNKNOWN) return newData.itow;
+    if (newData.content & CONTENT_TIME) return newData.time_ms;
+    return -1;
+}
+
+void IGPSModule::assembleFix(const GPSData& newData)
+{
+    if (!(newData.content & FIX_CONTENT)) return;
+
+    const int64_t key = epochKey(newData);
+    if (key >= 0 && key != pendingKey)
     {
-        result = lastPos;
-        xSemaphoreGive(lastPos.dataMutex);
-        result.dataMutex = nullptr;
-        return result;
+        // New epoch, the previous one is published if it did not complete by itself
+        if (pendingKey >= 0)
+        {
+            if (!pendingPublished) publishFix();
+            epochContent = pendingSeen;
+        }
+        pendingFix = {};
+        pendingFix.timestamp = newData.timestamp;
+        pendingKey = key;
+        pendingSeen = 0;
+        pendingPublished = false;
     }
-    return result;
+
+    // Untimed messages (VTG, GSA) belong to the epoch in progress, late ones are dropped
+    if (pendingKey < 0 || pendingPublished) return;
+
+    mergeFix(newData);
+    pendingSeen |= newData.content & FIX_CONTENT;
+
+    if (epochContent != 0 && (pendingSeen & epochContent) == epochContent)
+        publishFix();
 }
 
-IGPSModule::Velocity IGPSModule::getVel() const
+void IGPSModule::mergeFix(const GPSData& newData)
 {
-    Velocity result = {};
-    result.valid = false;
-    if (xSemaphoreTake(lastVel.dataMutex, 100) == pdTRUE)
+    Fix& fix = pendingFix;
+
+    if (newData.content & CONTENT_TIME)
     {
-        result = lastVel;
-        xSemaphoreGive(lastVel.dataMutex);
-        result.dataMutex = nullptr;
-        return result;
+        fix.time_ms = newData.time_ms;
+        fix.content |= CONTENT_TIME;
     }
-    return result;
+    if (newData.content & CONTENT_DOP)
+    {
+        fix.fix_type = newData.fix_type;
+        fix.pdop = newData.pdop;
+        if (!std::isnan(newData.vdop)) fix.vdop = newData.vdop;
+        fix.content |= CONTENT_DOP;
+    }
+    // GGA and NAV-SOL
+    if (newData.satellites > 0) fix.satellites = newData.satellites;
+    if (newData.hdop > 0) fix.hdop = newData.hdop;
+
+    if (!newData.valid) return;
+
+    if (newData.content & CONTENT_POS)
+    {
+        fix.lat_e7 = newData.lat_e7;
+        fix.lon_e7 = newData.lon_e7;
+    }
+    if (newData.content & CONTENT_ALT) fix.alt = newData.alt;
+    if (newData.content & CONTENT_VEL)
+    {
+        fix.spd = newData.spd;
+        fix.hdg = newData.hdg;
+    }
+    if (newData.content & CONTENT_DATE)
+    {
+        fix.day = newData.day;
+        fix.month = newData.month;
+        fix.year = newData.year;
+    }
+    fix.content |= newData.content & (CONTENT_POS | CONTENT_ALT | CONTENT_VEL | CONTENT_DATE);
+    fix.valid = fix.content & CONTENT_POS;
 }
 
-IGPSModule::Altitude IGPSModule::getAlt() const
+void IGPSModule::setPPS(const PPSCapture* capture)
+{
+    pps = capture;
+}
+
+void IGPSModule::publishFix()
 {
-    Altitude result = {};
-    result.valid = false;
-    if (xSemaphoreTake(lastAlt.dataMutex, 100) == pdTRUE)
+    pendingPublished = true;
+    if (pps != nullptr && (pendingFix.content & CONTENT_TIME))
+        pendingFix.acquired = pps->resolve(pendingFix.time_ms, pendingFix.timestamp);
+
+    if (pendingFix.valid)
     {
-        result = lastAlt;
-        xSemaphoreGive(lastAlt.dataMutex);
-        result.dataMutex = nullptr;
-        return result;
+        // Pulse time if known, push() drops fixes that end up older than the newest stored one
+        FixHistory::Sample sample;
+        sample.time = pendingFix.acquired >= 0 ? pendingFix.acquired : pendingFix.timestamp;
+        sample.content = pendingFix.content;
+        sample.time_ms = pendingFix.time_ms;
+        sample.lat_e7 = pendingFix.lat_e7;
+        sample.lon_e7 = pendingFix.lon_e7;
+        sample.alt = pendingFix.alt;
+        sample.spd = pendingFix.spd;
+        sample.hdg = pendingFix.hdg;
+        history.push(sample);
     }
-    return result;
+
+    if ((pendingFix.content & CONTENT_TIME) && (pendingFix.content & CONTENT_DATE))
+    {
+        const bool pulse = pendingFix.acquired >= 0;
+        utcClock.update(pulse ? pendingFix.acquired : pendingFix.timestamp,
+                        GPSClock::toUnixUs(pendingFix.year, pendingFix.month, pendingFix.day, pendingFix.time_ms),
+                        pulse);
+    }
+
+    lastFix.store(pendingFix);
 }
 
-IGPSModule::TimeDate IGPSModule::getTime() const
+const GPSClock& IGPSModule::getClock() const
 {
-    TimeDate result = {};
-    result.valid = false;
-    if (xSemaphoreTake(lastTime.dataMutex, 100) == pdTRUE)
+    return utcClock;
+}
+
+void IGPSModule::storeDop(const GPSData& newData)
+{
+    uint8_t used = 0;
+    for (const uint8_t prn : newData.used_prn)
+        if (prn != 0) used++;
+    // UBX NAV-SOL reports only the count
+    if (used == 0) used = newData.satellites;
+
+    // Satellite counts stay from the last GSV sequence
+    Quality quality = lastQuality.current();
+    quality.valid = newData.valid;
+    quality.timestamp = newData.timestamp;
+    quality.fix_type = newData.fix_type;
+    quality.used = used;
+    quality.pdop = newData.pdop;
+    // NaN from a UBX epoch without NAV-DOP, the last known values stay
+    if (!std::isnan(newData.hdop)) quality.hdop = newData.hdop;
+    if (!std::isnan(newData.vdop)) quality.vdop = newData.vdop;
+    lastQuality.store(quality);
+}
+
+void IGPSModule::storeSatellites(const GPSData& newData)
+{
+    if (newData.gsv_index == 1)
+    {
+        gsvTracked = 0;
+        gsvMaxSnr = 0;
+    }
+    for (const auto& sat : newData.sats)
     {
-        result = lastTime;
-        xSemaphoreGive(lastTime.dataMutex);
-        result.dataMutex = nullptr;
-        return result;
+        if (sat.prn == 0 || sat.snr < 0) continue;
+        gsvTracked++;
+        if (sat.snr > gsvMaxSnr) gsvMaxSnr = sat.snr;
     }
-    return result;
+    if (newData.gsv_index != newData.gsv_total) return;
+
+    Quality quality = lastQuality.current();
+    quality.in_view = newData.in_view;
+    quality.tracked = gsvTracked;
+    quality.max_snr = gsvMaxSnr;
+    lastQuality.store(quality);
 }
 
 void IGPSModule::updateData(const GPSData& newData)
@@ -103,62 +261,16 @@ void IGPSModule::updateData(const GPSData& newData)
         ESP_LOGW(TAG.data(), "Parsing error!");
         return;
     }
-    //TODO!
-    if (newData.type == "GGA")
-    {
-        if (newData.valid)
-        {
-            if (xSemaphoreTake(lastPos.dataMutex, 100) == pdTRUE)
-            {
-                lastPos.valid = true;
-                lastPos.timestamp = newData.timestamp;
-                lastPos.time = newData.time;
-                lastPos.lon = newData.lon;
-                lastPos.lat = newData.lat;
-                xSemaphoreGive(lastPos.dataMutex);
-            }
-            if (xSemaphoreTake(lastAlt.dataMutex, 100) == pdTRUE)
-            {
-                lastAlt.valid = true;
-                lastAlt.timestamp = newData.timestamp;
-                lastAlt.time = newData.time;
-                lastAlt.alt = newData.alt;
-                xSemaphoreGive(lastAlt.dataMutex);
-            }
-        }
-    }
-    else if (newData.type == "RMC")
-    {
-        if (newData.valid)
-        {
-            if (xSemaphoreTake(lastVel.dataMutex, 100) == pdTRUE)
-            {
-                lastVel.valid = true;
-                lastVel.timestamp = newData.timestamp;
-                lastVel.time = newData.time;
-                lastVel.spd = newData.spd;
-                lastVel.hdg = newData.hdg;
-                xSemaphoreGive(lastVel.dataMutex);
-            }
-            if (xSemaphoreTake(lastTime.dataMutex, 100) == pdTRUE)
-            {
-                lastTime.valid = true;
-                lastTime.timestamp = newData.timestamp;
-                lastTime.time = newData.time;
-                lastTime.date = newData.date;
-                xSemaphoreGive(lastTime.dataMutex);
-            }
-        }
-    }
-    else if (newData.type == "TXT")
-    {
+    if (newData.type == NMEAType::TXT)
         ESP_LOGV(TAG.data(), "\n📝 TXT | ✓: %s\n└─ %s",
                  newData.checksum ? "✅" : "❌",
-                 newData.text.c_str());
-    }
-    else
-    {
-    }
+                 newData.text);
+
+    assembleFix(newData);
+
+    // Quality is reported without a fix as well
+    if (newData.content & CONTENT_DOP) storeDop(newData);
+    if (newData.content & CONTENT_SATS) storeSatellites(newData);
 }
 
 void IGPSModule::printLastData() const
@@ -167,39 +279,52 @@ void IGPSModule::printLastData() const
     Velocity vel = getVel();
     Altitude alt = getAlt();
     TimeDate time = getTime();
+    Quality quality = getQuality();
+    GPSClock::Quality clock = utcClock.getQuality();
 
-    // Parse date (format: DDMMYY)
-    int day = static_cast<int>(time.date) / 10000;
-    int month = (static_cast<int>(time.date) / 100) % 100;
-    int year = static_cast<int>(time.date) % 100 + 2000;
+    const int hours = time.time_ms / 3600000;
+    const int minutes = time.time_ms / 60000 % 60;
+    const int seconds = time.time_ms / 1000 % 60;
+    const int milliseconds = time.time_ms % 1000;
 
-    // Parse time (format: HHMMSS.sss)
-    int hours = static_cast<int>(time.time) / 10000;
-    int minutes = (static_cast<int>(time.time) / 100) % 100;
-    int seconds = static_cast<int>(time.time) % 100;
-    int milliseconds = static_cast<int>((time.time - static_cast<int>(time.time)) * 1000);
+    // Coordinates are printed from fixed point without going through floats
+    const char* lat_sign = pos.lat_e7 < 0 ? "-" : "";
+    const char* lon_sign = pos.lon_e7 < 0 ? "-" : "";
+    const uint32_t lat_abs = pos.lat_e7 < 0 ? -static_cast<uint32_t>(pos.lat_e7) : pos.lat_e7;
+    const uint32_t lon_abs = pos.lon_e7 < 0 ? -static_cast<uint32_t>(pos.lon_e7) : pos.lon_e7;
 
     ESP_LOGI(TAG.data(),
              "\n📍 GPS Data Summary"
              "\n├─ 🎯 Position (valid: %s)"
-             "\n│  ├─ 🌍 Latitude:  %.7f°"
-             "\n│  └─ 🌎 Longitude: %.7f°"
+             "\n│  ├─ 🌍 Latitude:  %s%lu.%07lu°"
+             "\n│  └─ 🌎 Longitude: %s%lu.%07lu°"
              "\n├─ 🚀 Movement (valid: %s)"
              "\n│  ├─ 💨 Speed:     %.1f m/s"
              "\n│  └─ 🧭 Heading:   %.1f°"
              "\n├─ ⬆️ Altitude (valid: %s)"
              "\n│  └─ 📏 Height:    %.1f m"
+             "\n├─ 🛰️ Quality (valid: %s)"
+             "\n│  ├─ 📡 Fix:       %dD, %d used, %d/%d tracked, max SNR %d dB"
+             "\n│  └─ 🎯 DOP:       P %.2f H %.2f V %.2f"
+             "\n├─ ⏱️ Clock (synced: %s, %s)"
+             "\n│  └─ 📐 Error:     %lu us, drift %ld ppb"
              "\n└─ 🕒 Timing (valid: %s)"
              "\n   ├─ 📅 Date:      %02d.%02d.%04d"
              "\n   └─ ⏰ Time:      %02d:%02d:%02d.%03d",
              pos.valid ? "✅" : "❌",
-             pos.lat, pos.lon,
+             lat_sign, static_cast<unsigned long>(lat_abs / 10000000), static_cast<unsigned long>(lat_abs % 10000000),
+             lon_sign, static_cast<unsigned long>(lon_abs / 10000000), static_cast<unsigned long>(lon_abs % 10000000),
              vel.valid ? "✅" : "❌",
              vel.spd, vel.hdg,
              alt.valid ? "✅" : "❌",
              alt.alt,
+             quality.valid ? "✅" : "❌",
+             quality.fix_type, quality.used, quality.tracked, quality.in_view, quality.max_snr,
+             quality.pdop, quality.hdop, quality.vdop,
+             clock.synced ? "✅" : "❌", clock.pps ? "PPS" : "UART",
+             static_cast<unsigned long>(clock.error_us), static_cast<long>(clock.drift_ppb),
              time.valid ? "✅" : "❌",
-             day, month, year,
+             time.day, time.month, time.year,
              hours, minutes, seconds, milliseconds
     );
 }
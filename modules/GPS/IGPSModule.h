@@ -7,92 +7,201 @@
 
 #include <cstdint>
 #include <string>
-#include <freertos/FreeRTOS.h>
-#include <freertos/semphr.h>
+#include <esp_err.h>
 
+#include "Common/Snapshot.h"
+#include "FixHistory.h"
+#include "GPSClock.h"
+#include "NMEASentence.h"
+
+class PPSCapture;
 
 class IGPSModule
 {
 public:
+    // What a decoded message carries, NMEA and UBX messages are stored by content rather than by type
+    enum content_t : uint8_t
+    {
+        CONTENT_POS = 1 << 0,
+        CONTENT_ALT = 1 << 1,
+        CONTENT_VEL = 1 << 2,
+        CONTENT_TIME = 1 << 3, // time_ms is set
+        CONTENT_DATE = 1 << 4,
+        CONTENT_DOP = 1 << 5,
+        CONTENT_SATS = 1 << 6
+    };
+
+    struct Satellite
+    {
+        uint8_t prn = 0;
+        int8_t elevation = 0;
+        uint16_t azimuth = 0;
+        int8_t snr = -1; // -1 if not tracked
+    };
+
     struct GPSData
     {
         int64_t timestamp = 0;
         bool checksum = false;
         bool ignore = false;
         bool parse_error = false;
-        std::string source = "";
-        std::string type = "";
+        NMEATalker source = NMEATalker::UNKNOWN;
+        NMEAType type = NMEAType::UNKNOWN; // UNKNOWN for UBX messages
+        uint8_t content = 0;               // content_t flags
         bool valid = false;
-        float time = 0;
-        float date = 0;
-        double lat = 0;
-        double lon = 0;
+        uint32_t itow = 0;   // UBX GPS time of week, ms
+        int32_t time_ms = 0; // UTC milliseconds since midnight
+        uint8_t day = 0;
+        uint8_t month = 0;
+        uint16_t year = 0;
+        int32_t lat_e7 = 0; // 1e-7 degrees
+        int32_t lon_e7 = 0; // 1e-7 degrees
         float alt = 0;
         float spd = 0;
         float hdg = 0;
-        std::string text = "";
+        char text[72] = {};
         int satellites = 0;
-        float hdop;
+        float hdop = 0; // NaN when a UBX epoch had no NAV-DOP
+        // GSA
+        uint8_t fix_type = 0; // 1 - no fix, 2 - 2D, 3 - 3D
+        uint8_t used_prn[12] = {};
+        float pdop = 0;
+        float vdop = 0;
+        // GSV
+        uint8_t gsv_total = 0;
+        uint8_t gsv_index = 0;
+        uint8_t in_view = 0;
+        Satellite sats[4];
+    };
+
+    // All components of one navigation epoch, published at once
+    struct Fix
+    {
+        int64_t timestamp = -1; // Reception of the first message of the epoch
+        int64_t acquired = -1;  // esp_timer time of the fix instant from the time pulse, -1 without PPS
+        bool valid = false;     // Position is set
+        uint8_t content = 0;    // content_t flags of the components present
+        int32_t time_ms = 0;
+        uint8_t day = 0;
+        uint8_t month = 0;
+        uint16_t year = 0;
+        int32_t lat_e7 = 0;
+        int32_t lon_e7 = 0;
+        float alt = 0;
+        float spd = 0;
+        float hdg = 0;
+        uint8_t fix_type = 0;
+        uint8_t satellites = 0;
+        float pdop = 0;
+        float hdop = 0;
+        float vdop = 0;
     };
 
     struct Position
     {
-        SemaphoreHandle_t dataMutex = nullptr;
         int64_t timestamp = -1;
         bool valid = false;
-        float time = 0;
-        double lat = 0;
-        double lon = 0;
+        int32_t time_ms = 0;
+        int32_t lat_e7 = 0;
+        int32_t lon_e7 = 0;
     };
 
     struct Velocity
     {
-        SemaphoreHandle_t dataMutex = nullptr;
         int64_t timestamp = -1;
         bool valid = false;
-        float time = 0;
+        int32_t time_ms = 0;
         float spd = 0;
         float hdg = 0;
     };
 
     struct Altitude
     {
-        SemaphoreHandle_t dataMutex = nullptr;
         int64_t timestamp = -1;
         bool valid = false;
-        float time = 0;
+        int32_t time_ms = 0;
         float alt = 0;
     };
 
     struct TimeDate
     {
-        SemaphoreHandle_t dataMutex = nullptr;
         int64_t timestamp = -1;
         bool valid = false;
-        float time = 0;
-        float date = 0;
+        int32_t time_ms = 0;
+        uint8_t day = 0;
+        uint8_t month = 0;
+        uint16_t year = 0;
+    };
+
+    struct Quality
+    {
+        int64_t timestamp = -1;
+        bool valid = false;
+        uint8_t fix_type = 0;
+        uint8_t used = 0;    // Satellites used in solution
+        uint8_t in_view = 0;
+        uint8_t tracked = 0; // Satellites in view with SNR
+        uint8_t max_snr = 0;
+        float pdop = 0;
+        float hdop = 0;
+        float vdop = 0;
     };
 
 private:
     std::string TAG;
 
-    Position lastPos;
-    Velocity lastVel;
-    Altitude lastAlt;
-    TimeDate lastTime;
+    // Components of a fix, an epoch is complete when it has everything the previous one had
+    static constexpr uint8_t FIX_CONTENT = CONTENT_POS | CONTENT_ALT | CONTENT_VEL | CONTENT_TIME | CONTENT_DATE |
+        CONTENT_DOP;
+
+    // Published by the task calling updateData, read without locks
+    Snapshot<Fix> lastFix;
+    Snapshot<Quality> lastQuality;
+
+    const PPSCapture* pps;
+    GPSClock utcClock;
+    FixHistory history;
+
+    // Epoch being assembled, touched only by the task calling updateData
+    Fix pendingFix;
+    int64_t pendingKey;     // UTC time or UBX iTOW of the epoch, -1 if none
+    uint8_t pendingSeen;    // Content of all messages received in the epoch, valid or not
+    uint8_t epochContent;   // pendingSeen of the previous epoch
+    bool pendingPublished;
+
+    // GSV sequence accumulated until its last sentence
+    uint8_t gsvTracked;
+    uint8_t gsvMaxSnr;
+
+    static int64_t epochKey(const GPSData& newData);
+    void assembleFix(const GPSData& newData);
+    void mergeFix(const GPSData& newData);
+    void publishFix();
+    void storeDop(const GPSData& newData);
+    void storeSatellites(const GPSData& newData);
 
 protected:
     IGPSModule();
 
     void updateData(const GPSData& newData);
+    // Time pulse used to time fixes, nullptr if not wired
+    void setPPS(const PPSCapture* capture);
 
 public:
     virtual ~IGPSModule();
 
+    Fix getFix() const;
     Position getPos() const;
     Velocity getVel() const;
     Altitude getAlt() const;
     TimeDate getTime() const;
+    // Interpolated from the fix history at an esp_timer time, invalid outside of it
+    Position getPosAt(int64_t time) const;
+    Velocity getVelAt(int64_t time) const;
+    Altitude getAltAt(int64_t time) const;
+    Quality getQuality() const;
+    // esp_timer <-> UTC conversions, updated by every fix with time and date
+    const GPSClock& getClock() const;
 
     //TODO its for debug
     void printLastData() const;
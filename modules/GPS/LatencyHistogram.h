@@ -0,0 +1,93 @@
+//
+// Created by stikper on 06.05.25.
+//
+
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+
+// Power-of-two microsecond buckets: bucket 0 is < 1 us, bucket i is [2^(i-1), 2^i) us,
+// the last one takes everything above. Recording is wait-free, readers may run on any task.
+class LatencyHistogram
+{
+public:
+    static constexpr size_t BUCKETS = 20; // Last bucket starts at ~262 ms
+
+    struct Snapshot
+    {
+        uint32_t counts[BUCKETS] = {};
+        uint32_t total = 0;
+        int64_t max_us = 0;
+
+        // Upper bound of the bucket holding the given percentile, never above the maximum, -1 if empty
+        int64_t percentile(const uint32_t pct) const
+        {
+            if (total == 0) return -1;
+
+            const uint64_t rank = (static_cast<uint64_t>(total) * pct + 99) / 100;
+            uint64_t seen = 0;
+            for (size_t i = 0; i < BUCKETS; i++)
+            {
+                seen += counts[i];
+                if (seen < rank || seen == 0) continue;
+                // Last bucket is open, and the recorded maximum is a tighter bound than any bucket edge above it
+                return i + 1 < BUCKETS && upperBound(i) < max_us ? upperBound(i) : max_us;
+            }
+            return max_us;
+        }
+    };
+
+private:
+    std::atomic<uint32_t> counts[BUCKETS];
+    std::atomic<uint32_t> max_us; // 32 bit to stay lock-free on Xtensa
+
+public:
+    LatencyHistogram()
+    {
+        reset();
+    }
+
+    static constexpr int64_t upperBound(const size_t bucket)
+    {
+        return static_cast<int64_t>(1) << bucket;
+    }
+
+    void record(const int64_t us)
+    {
+        const size_t bucket = us <= 0 ? 0 : std::bit_width(static_cast<uint64_t>(us));
+        counts[bucket < BUCKETS ? bucket : BUCKETS - 1].fetch_add(1, std::memory_order_relaxed);
+
+        const uint32_t value = us <= 0 ? 0 : us < UINT32_MAX ? static_cast<uint32_t>(us) : UINT32_MAX;
+        uint32_t max = max_us.load(std::memory_order_relaxed);
+        while (value > max && !max_us.compare_exchange_weak(max, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    Snapshot snapshot() const
+    {
+        Snapshot result;
+        for (size_t i = 0; i < BUCKETS; i++)
+        {
+            result.counts[i] = counts[i].load(std::memory_order_relaxed);
+            result.total += result.counts[i];
+        }
+        result.max_us = max_us.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    void reset()
+    {
+        for (auto& count : counts)
+            count.store(0, std::memory_order_relaxed);
+        max_us.store(0, std::memory_order_relaxed);
+    }
+};
+
+
+#endif //LATENCYHISTOGRAM_H
@@ -6,29 +6,53 @@
 
 #include <cstring>
 #include <esp_log.h>
+#include <esp_timer.h>
+#include <sdkconfig.h>
 #include <stdexcept>
-#include <driver/uart.h>
 
-NEO6M::NEO6M(): cfg{}
+NEO6M::neo6m_config_t NEO6M::defaultConfig()
+{
+    neo6m_config_t config{};
+
+    // TODO: Remove hardcode
+    config.protocol = PROTOCOL_NMEA;
+    config.ingest_mode = INGEST_DIRECT;
+    config.configure_receiver = true;
+    config.uart_buffer_size = CONFIG_GPS_UART_BUFFER_SIZE;
+    config.uart_port_num = static_cast<uart_port_t>(CONFIG_GPS_UART_PORT_NUM);
+    config.uart_baud_rate = CONFIG_GPS_UART_BAUD_RATE;
+    config.uart_target_baud_rate = CONFIG_GPS_UART_TARGET_BAUD_RATE;
+    config.nav_rate_hz = CONFIG_GPS_NAV_RATE_HZ;
+    config.uart_queue_size = CONFIG_GPS_QUEUE_SIZE;
+    config.uart_rxd = CONFIG_GPS_UART_RXD;
+    config.uart_txd = CONFIG_GPS_UART_TXD;
+    config.uart_task_stack_size = 2048;
+    config.uart_task_priority = 12;
+    config.gps_task_stack_size = CONFIG_GPS_TASK_STACK_SIZE;
+    config.gps_task_priority = CONFIG_GPS_TASK_PRIORITY;
+    config.nmea_task_stack_size = 4096;
+    config.nmea_task_priority = 13;
+    config.pps_gpio = CONFIG_GPS_PPS_GPIO;
+
+    return config;
+}
+
+NEO6M::NEO6M(IUARTPort* port): NEO6M(port, defaultConfig())
+{
+}
+
+NEO6M::NEO6M(IUARTPort* port, const neo6m_config_t& config): cfg(config), port(port)
 {
     TAG = "NEO-6M";
     ESP_LOGI(TAG.data(), "Initializing...");
 
-    // TODO: Remove hardcode
     // TODO: Add verbose logging
     // TODO: Add malloc checks
-    // TODO: config sequence
-    // Setting configuration
-    cfg.uart_buffer_size = 1024;
-    cfg.uart_port_num = UART_NUM_2;
-    cfg.uart_baud_rate = 9600;
-    cfg.uart_queue_size = 16;
-    cfg.uart_rxd = 16;
-    cfg.uart_txd = 17;
-    cfg.uart_task_stack_size = 2048;
-    cfg.uart_task_priority = 12;
-    cfg.nmea_task_stack_size = 4096;
-    cfg.nmea_task_priority = 13;
+    if (port == nullptr)
+    {
+        ESP_LOGE(TAG.data(), "No UART port given");
+        throw std::runtime_error("NEO6M requires a UART port"); // TODO: Test throw error
+    }
 
     // Create uart buffer
     uart_buffer = new char[cfg.uart_buffer_size];
@@ -36,13 +60,16 @@ NEO6M::NEO6M(): cfg{}
 
     // Initializing variables
     uart_buffer_len = 0;
+    link_baud_rate = cfg.uart_baud_rate;
 
     uartQueue = nullptr;
     nmeaQueue = nullptr;
+    spare_slot = NO_SLOT;
     uart_task_handle = nullptr;
     nmea_task_handle = nullptr;
 
     running = false;
+    setPPS(&pps);
 
     ESP_LOGI(TAG.data(), "Module is ready to start!");
 }
@@ -60,42 +87,54 @@ NEO6M::~NEO6M()
 
 esp_err_t NEO6M::initUART()
 {
-    // Config and install uart driver
-    const uart_config_t uart_config = {
+    // Direct ingestion reads the driver buffer without an event queue
+    const bool events = cfg.ingest_mode != INGEST_DIRECT;
+    const IUARTPort::uart_port_config_t port_config = {
+        .port_num = cfg.uart_port_num,
         .baud_rate = cfg.uart_baud_rate,
-        .data_bits = UART_DATA_8_BITS,
-        .parity = UART_PARITY_DISABLE,
-        .stop_bits = UART_STOP_BITS_1,
-        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
-        .source_clk = UART_SCLK_DEFAULT
+        .txd = cfg.uart_txd,
+        .rxd = cfg.uart_rxd,
+        .rx_buffer_size = cfg.uart_buffer_size * 2,
+        .event_queue_size = events ? cfg.uart_queue_size : 0
     };
-
-    esp_err_t ret = uart_driver_install(cfg.uart_port_num, cfg.uart_buffer_size * 2, 0, cfg.uart_queue_size, &uartQueue,
-                                        0);
+    esp_err_t ret = port->open(port_config);
     if (ret != ESP_OK) return ret;
+    uartQueue = port->getEventQueue();
+    link_baud_rate = cfg.uart_baud_rate;
 
-    ret = uart_param_config(cfg.uart_port_num, &uart_config);
-    if (ret != ESP_OK) return ret;
-
-    ret = uart_set_pin(cfg.uart_port_num, cfg.uart_txd, cfg.uart_rxd, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
-    if (ret != ESP_OK) return ret;
-
-    // Set uart pattern
-    ret = uart_enable_pattern_det_baud_intr(cfg.uart_port_num, '\n', 1, 9, 0, 0);
-    if (ret != ESP_OK) return ret;
+    if (cfg.configure_receiver)
+    {
+        ret = configReceiver();
+        if (ret != ESP_OK)
+            ESP_LOGW(TAG.data(), "Receiver configuration failed, using its current settings: %d", ret);
+    }
+    ubxStream.reset();
+    nmeaStream.reset();
 
-    ret = uart_pattern_queue_reset(cfg.uart_port_num, cfg.uart_queue_size);
-    if (ret != ESP_OK) return ret;
+    if (cfg.ingest_mode == INGEST_PATTERN)
+    {
+        // Set uart pattern
+        ret = port->enablePattern('\n', cfg.uart_queue_size);
+        if (ret != ESP_OK) return ret;
+    }
+    else
+    {
+        // Deliver the tail of an epoch burst right after the line goes idle
+        ret = port->setRxTimeout(2);
+        if (ret != ESP_OK) return ret;
+    }
 
-    ret = uart_flush(cfg.uart_port_num);
+    ret = port->flushInput();
+    if (uartQueue != nullptr)
+        xQueueReset(uartQueue);
     return ret;
 }
 
-esp_err_t NEO6M::removeUART() const
+esp_err_t NEO6M::removeUART()
 {
-    // Delete uart driver
-    esp_err_t ret = uart_driver_delete(cfg.uart_port_num);
-    return ret;
+    // Delete uart driver, event queue goes with it
+    uartQueue = nullptr;
+    return port->close();
 }
 
 void NEO6M::uartTaskWrapper(void* param)
@@ -114,22 +153,29 @@ _Noreturn void NEO6M::processUART()
 
     while (true)
     {
-        // Waiting for UART event.
-        if (running && xQueueReceive(uartQueue, &event, pdMS_TO_TICKS(200)) == pdTRUE)
+        // Waiting for UART event, timeout only lets the task see running
+        if (xQueueReceive(uartQueue, &event, pdMS_TO_TICKS(200)) == pdTRUE && running)
         {
+            const int64_t received = esp_timer_get_time();
             switch (event.type)
             {
             case UART_DATA:
+                if (cfg.ingest_mode == INGEST_STREAM)
+                    processData(event.size, received);
                 break;
             case UART_FIFO_OVF:
                 ESP_LOGW(TAG.data(), "HW FIFO Overflow");
-                uart_flush(cfg.uart_port_num);
+                port->flushInput();
                 xQueueReset(uartQueue);
+                nmeaStream.reset();
+                ubxStream.reset();
                 break;
             case UART_BUFFER_FULL:
                 ESP_LOGW(TAG.data(), "Ring Buffer Full");
-                uart_flush(cfg.uart_port_num);
+                port->flushInput();
                 xQueueReset(uartQueue);
+                nmeaStream.reset();
+                ubxStream.reset();
                 break;
             case UART_BREAK:
                 ESP_LOGW(TAG.data(), "Rx Break");
@@ -141,41 +187,285 @@ _Noreturn void NEO6M::processUART()
                 ESP_LOGW(TAG.data(), "Frame Error");
                 break;
             case UART_PATTERN_DET:
-                processPattern();
+                processPattern(received);
                 break;
             default:
                 ESP_LOGW(TAG.data(), "Unknown uart event type: %d", event.type);
                 break;
             }
         }
-        vTaskDelay(pdMS_TO_TICKS(10));
     }
 }
 
-void NEO6M::processPattern()
+void NEO6M::gpsTaskWrapper(void* param)
+{
+    auto* gps = static_cast<NEO6M*>(param);
+
+    gps->processDirect();
+}
+
+_Noreturn void NEO6M::processDirect()
+{
+    using GPSData = IGPSModule::GPSData;
+    GPSData newData;
+
+    while (true)
+    {
+        // Block for the first byte of a burst, then take everything the driver already holds.
+        // Timeout only lets the task see running
+        int read_len = port->read(uart_buffer, 1, pdMS_TO_TICKS(200));
+        if (read_len <= 0 || !running) continue;
+        const int64_t received = esp_timer_get_time();
+
+        size_t buffered = port->getBufferedLength();
+        if (buffered > static_cast<size_t>(cfg.uart_buffer_size) - 1) buffered = cfg.uart_buffer_size - 1;
+        if (buffered > 0)
+        {
+            const int rest = port->read(uart_buffer + 1, buffered, 0);
+            if (rest > 0) read_len += rest;
+        }
+
+        for (int i = 0; i < read_len; i++)
+            processByte(static_cast<uint8_t>(uart_buffer[i]), &newData, received);
+    }
+}
+
+void NEO6M::processPattern(const int64_t received)
+{
+    int pos = port->popPattern();
+
+    if (pos == -1)
+    {
+        ESP_LOGW(TAG.data(), "Pattern Queue Size too small");
+        port->flushInput();
+        return;
+    }
+
+    // Slot that could not be queued last time is reused
+    uint8_t slot;
+    if (spare_slot != NO_SLOT)
+    {
+        slot = spare_slot;
+        spare_slot = NO_SLOT;
+    }
+    else if (!sentencePool.acquire(&slot))
+    {
+        sentencePool.drop();
+        discardBytes(pos + 1);
+        return;
+    }
+
+    const size_t line_len = pos + 1;
+    const size_t slot_len = line_len < sentence_pool_t::SLOT_SIZE ? line_len : sentence_pool_t::SLOT_SIZE;
+    const int read_len = port->read(sentencePool.data(slot), slot_len, pdMS_TO_TICKS(200));
+    if (line_len > slot_len)
+    {
+        // Longer than any NMEA sentence, the rest of the line is discarded
+        discardBytes(line_len - slot_len);
+        sentencePool.drop();
+        spare_slot = slot;
+        return;
+    }
+    sentencePool.setLength(slot, read_len > 0 ? read_len : 0);
+    sentencePool.setTimestamp(slot, received);
+
+    if (xQueueSend(nmeaQueue, &slot, 0) != pdTRUE)
+    {
+        sentencePool.drop();
+        spare_slot = slot;
+    }
+}
+
+void NEO6M::discardBytes(size_t size) const
+{
+    while (size > 0)
+    {
+        const size_t chunk = size < static_cast<size_t>(cfg.uart_buffer_size) ? size : cfg.uart_buffer_size;
+        const int read_len = port->read(uart_buffer, chunk, pdMS_TO_TICKS(200));
+        if (read_len <= 0) return;
+        size -= read_len;
+    }
+}
+
+void NEO6M::processData(size_t size, const int64_t received)
+{
+    using GPSData = IGPSModule::GPSData;
+    GPSData newData;
+
+    while (size > 0)
+    {
+        const size_t chunk = size < static_cast<size_t>(cfg.uart_buffer_size) ? size : cfg.uart_buffer_size;
+        const int read_len = port->read(uart_buffer, chunk, 0);
+        if (read_len <= 0) return;
+
+        for (int i = 0; i < read_len; i++)
+            processByte(static_cast<uint8_t>(uart_buffer[i]), &newData, received);
+        size -= read_len;
+    }
+}
+
+void NEO6M::processByte(const uint8_t byte, GPSData* newData, const int64_t received)
 {
-    int pos = uart_pattern_pop_pos(cfg.uart_port_num);
+    // Both protocols may share the line while the receiver switches output,
+    // bytes of a UBX frame are never passed to the NMEA decoder
+    if (ubxStream.feed(byte, newData))
+    {
+        deliver(*newData, received);
+        return;
+    }
+    if (!ubxStream.idle()) return;
+
+    if (nmeaStream.feed(static_cast<char>(byte), newData))
+        deliver(*newData, received);
+}
+
+void NEO6M::deliver(const GPSData& newData, const int64_t received)
+{
+    updateData(newData);
+    latency.record(esp_timer_get_time() - received);
+}
 
-    if (pos != -1)
+esp_err_t NEO6M::sendUBX(const uint8_t cls, const uint8_t id, const uint8_t* payload, const uint16_t length) const
+{
+    uint8_t frame[UBXStream::MAX_PAYLOAD + UBXStream::FRAME_OVERHEAD];
+    const size_t size = UBXStream::encode(cls, id, payload, length, frame, sizeof(frame));
+    if (size == 0) return ESP_ERR_INVALID_SIZE;
+
+    if (port->write(frame, size) != static_cast<int>(size)) return ESP_FAIL;
+    return port->waitTxDone(pdMS_TO_TICKS(100));
+}
+
+esp_err_t NEO6M::waitAck(const uint8_t cls, const uint8_t id)
+{
+    using GPSData = IGPSModule::GPSData;
+    GPSData scratch;
+
+    const int64_t deadline = esp_timer_get_time() + UBX_ACK_TIMEOUT_MS * 1000;
+    while (esp_timer_get_time() < deadline)
     {
-        if (pos + 1 >= cfg.uart_buffer_size)
+        const int read_len = port->read(uart_buffer, cfg.uart_buffer_size, pdMS_TO_TICKS(10));
+        for (int i = 0; i < read_len; i++)
         {
-            ESP_LOGW(TAG.data(), "GPS UART buffer too small");
-            pos = cfg.uart_buffer_size - 2;
+            if (!ubxStream.feed(static_cast<uint8_t>(uart_buffer[i]), &scratch)) continue;
+
+            const UBXStream::Frame& frame = ubxStream.getFrame();
+            if (frame.cls != UBXStream::CLASS_ACK || frame.length != 2 ||
+                frame.payload[0] != cls || frame.payload[1] != id)
+                continue;
+            return frame.id == UBXStream::ACK_ACK ? ESP_OK : ESP_ERR_NOT_SUPPORTED;
         }
+    }
+    return ESP_ERR_TIMEOUT;
+}
 
-        const int read_len = uart_read_bytes(cfg.uart_port_num, uart_buffer, pos + 1, pdMS_TO_TICKS(200));
-        uart_buffer[read_len] = '\0';
-        const auto* nmea_ptr = new std::string(uart_buffer);
+esp_err_t NEO6M::sendUBXAck(const uint8_t cls, const uint8_t id, const uint8_t* payload, const uint16_t length)
+{
+    esp_err_t ret = ESP_ERR_TIMEOUT;
+    for (int attempt = 0; attempt < UBX_RETRIES && ret == ESP_ERR_TIMEOUT; attempt++)
+    {
+        ret = sendUBX(cls, id, payload, length);
+        if (ret != ESP_OK) return ret;
+        ret = waitAck(cls, id);
+    }
+    return ret;
+}
+
+bool NEO6M::probeReceiver(const int baud_rate)
+{
+    if (port->setBaudRate(baud_rate) != ESP_OK) return false;
+    port->flushInput();
+    ubxStream.reset();
+
+    // CFG-RATE poll is answered with the current rate and ACK-ACK
+    return sendUBXAck(UBXStream::CLASS_CFG, UBXStream::CFG_RATE, nullptr, 0) == ESP_OK;
+}
+
+esp_err_t NEO6M::configReceiver()
+{
+    // Receiver keeps its port settings while powered, so it may already run at the target rate
+    link_baud_rate = 0;
+    for (const int baud_rate : {cfg.uart_baud_rate, cfg.uart_target_baud_rate})
+    {
+        if (!probeReceiver(baud_rate)) continue;
+        link_baud_rate = baud_rate;
+        break;
+    }
+    if (link_baud_rate == 0)
+    {
+        ESP_LOGW(TAG.data(), "Receiver does not answer UBX commands");
+        port->setBaudRate(cfg.uart_baud_rate);
+        link_baud_rate = cfg.uart_baud_rate;
+        return ESP_ERR_TIMEOUT;
+    }
+    ESP_LOGI(TAG.data(), "Receiver found at %d baud", link_baud_rate);
 
-        // TODO: is it works?
-        xQueueSend(nmeaQueue, &nmea_ptr, 0);
+    // Message set, rate is per navigation solution
+    struct Message
+    {
+        uint8_t cls;
+        uint8_t id;
+        uint8_t nmea_rate;
+        uint8_t ubx_rate;
+    };
+    const auto gsv_rate = static_cast<uint8_t>(cfg.nav_rate_hz); // Satellites once per second
+    const Message messages[] = {
+        {0xF0, 0x00, 1, 0},        // GGA
+        {0xF0, 0x01, 0, 0},        // GLL
+        {0xF0, 0x02, 1, 0},        // GSA
+        {0xF0, 0x03, gsv_rate, 0}, // GSV
+        {0xF0, 0x04, 1, 0},        // RMC
+        {0xF0, 0x05, 0, 0},        // VTG
+        {UBXStream::CLASS_NAV, UBXStream::NAV_POSLLH, 0, 1},
+        {UBXStream::CLASS_NAV, UBXStream::NAV_DOP, 0, 1},
+        {UBXStream::CLASS_NAV, UBXStream::NAV_SOL, 0, 1},
+        {UBXStream::CLASS_NAV, UBXStream::NAV_VELNED, 0, 1},
+        {UBXStream::CLASS_NAV, UBXStream::NAV_TIMEUTC, 0, 1},
+    };
+    for (const auto& message : messages)
+    {
+        const uint8_t msg[3] = {
+            message.cls, message.id, cfg.protocol == PROTOCOL_UBX ? message.ubx_rate : message.nmea_rate
+        };
+        const esp_err_t ret = sendUBXAck(UBXStream::CLASS_CFG, UBXStream::CFG_MSG, msg, sizeof(msg));
+        if (ret != ESP_OK)
+            ESP_LOGW(TAG.data(), "CFG-MSG %02X-%02X failed: %d", message.cls, message.id, ret);
+    }
+
+    // Measurement period, one solution per measurement, aligned to GPS time
+    const auto period = static_cast<uint16_t>(1000 / cfg.nav_rate_hz);
+    const uint8_t rate[6] = {static_cast<uint8_t>(period), static_cast<uint8_t>(period >> 8), 0x01, 0x00, 0x01, 0x00};
+    esp_err_t ret = sendUBXAck(UBXStream::CLASS_CFG, UBXStream::CFG_RATE, rate, sizeof(rate));
+    if (ret != ESP_OK)
+        ESP_LOGW(TAG.data(), "CFG-RATE %d Hz failed: %d", cfg.nav_rate_hz, ret);
+
+    // UART1: 8N1, UBX+NMEA in, selected protocol out.
+    // ACK of the port change is sent while the speed switches, so it is verified by probing instead
+    const auto baud = static_cast<uint32_t>(cfg.uart_target_baud_rate);
+    const uint8_t prt[20] = {
+        0x01, 0x00, 0x00, 0x00,
+        0xD0, 0x08, 0x00, 0x00,
+        static_cast<uint8_t>(baud), static_cast<uint8_t>(baud >> 8),
+        static_cast<uint8_t>(baud >> 16), static_cast<uint8_t>(baud >> 24),
+        0x03, 0x00,
+        static_cast<uint8_t>(cfg.protocol == PROTOCOL_UBX ? 0x01 : 0x02), 0x00,
+        0x00, 0x00, 0x00, 0x00
+    };
+    ret = sendUBX(UBXStream::CLASS_CFG, UBXStream::CFG_PRT, prt, sizeof(prt));
+    if (ret != ESP_OK) return ret;
+    vTaskDelay(pdMS_TO_TICKS(100));
+
+    if (probeReceiver(cfg.uart_target_baud_rate))
+    {
+        link_baud_rate = cfg.uart_target_baud_rate;
     }
     else
     {
-        ESP_LOGW(TAG.data(), "Pattern Queue Size too small");
-        uart_flush_input(cfg.uart_port_num);
+        ESP_LOGW(TAG.data(), "No answer at %d baud, staying at %d", cfg.uart_target_baud_rate, link_baud_rate);
+        if (!probeReceiver(link_baud_rate)) return ESP_ERR_TIMEOUT;
     }
+    ESP_LOGI(TAG.data(), "Receiver configured: %d baud, %d Hz", link_baud_rate, cfg.nav_rate_hz);
+
+    return ESP_OK;
 }
 
 void NEO6M::nmeaTaskWrapper(void* param)
@@ -187,24 +477,41 @@ void NEO6M::nmeaTaskWrapper(void* param)
 
 _Noreturn void NEO6M::processNMEA()
 {
-    std::string* nmea_ptr;
+    uint8_t slot;
 
     while (true)
     {
-        //Waiting for UART event.
-        if (running && xQueueReceive(nmeaQueue, &nmea_ptr, pdMS_TO_TICKS(200)) == pdTRUE)
+        // Waiting for a line, timeout only lets the task see running
+        if (xQueueReceive(nmeaQueue, &slot, pdMS_TO_TICKS(200)) == pdTRUE)
         {
-            std::string nmea(*nmea_ptr);
-            delete nmea_ptr;
             using GPSData = IGPSModule::GPSData;
-            //TODO Add try catch
-            GPSData newData = NMEAParser::parse(nmea);
-            updateData(newData);
+            GPSData newData = NMEAParser::parse(sentencePool.view(slot));
+            const int64_t received = sentencePool.getTimestamp(slot);
+            sentencePool.release(slot);
+            if (!running) continue;
+
+            // Line was complete at the pattern interrupt, not when it got parsed
+            newData.timestamp = received;
+            deliver(newData, received);
         }
-        vTaskDelay(pdMS_TO_TICKS(10));
     }
 }
 
+LatencyHistogram::Snapshot NEO6M::getLatency() const
+{
+    return latency.snapshot();
+}
+
+void NEO6M::resetLatency()
+{
+    latency.reset();
+}
+
+uint32_t NEO6M::getDroppedSentences() const
+{
+    return sentencePool.getDrops();
+}
+
 esp_err_t NEO6M::start()
 {
     if (running) return ESP_OK;
@@ -213,25 +520,42 @@ esp_err_t NEO6M::start()
 
     esp_err_t ret;
 
-    ESP_LOGI(TAG.data(), "Initializing NMEA Queue...");
-    nmeaQueue = xQueueCreate(10, sizeof(void*));
-    const BaseType_t xReturned_1 = xTaskCreate(
-        nmeaTaskWrapper,
-        "nmea_parsing_task",
-        cfg.nmea_task_stack_size,
-        this,
-        cfg.nmea_task_priority,
-        &nmea_task_handle);
+    if (cfg.protocol == PROTOCOL_UBX && cfg.ingest_mode == INGEST_PATTERN)
+    {
+        // Binary frames have no line terminator to detect
+        ESP_LOGW(TAG.data(), "UBX protocol cannot use pattern ingestion, switching to direct");
+        cfg.ingest_mode = INGEST_DIRECT;
+    }
 
-    if (xReturned_1 != pdPASS)
+    if (cfg.ingest_mode == INGEST_PATTERN)
     {
-        ESP_LOGE(TAG.data(), "failed to create UART task");
-        ret = removeUART();
-        if (ret != ESP_OK)
-            ESP_LOGE(TAG.data(), "Failed to remove UART: %d", ret);
-        return ESP_FAIL;
+        ESP_LOGI(TAG.data(), "Initializing NMEA Queue...");
+        sentencePool.reset();
+        spare_slot = NO_SLOT;
+        nmeaQueue = xQueueCreate(sentence_pool_t::SLOTS, sizeof(uint8_t));
+        const BaseType_t xReturned_1 = xTaskCreate(
+            nmeaTaskWrapper,
+            "nmea_parsing_task",
+            cfg.nmea_task_stack_size,
+            this,
+            cfg.nmea_task_priority,
+            &nmea_task_handle);
+
+        if (xReturned_1 != pdPASS)
+        {
+            ESP_LOGE(TAG.data(), "failed to create UART task");
+            ret = removeUART();
+            if (ret != ESP_OK)
+                ESP_LOGE(TAG.data(), "Failed to remove UART: %d", ret);
+            return ESP_FAIL;
+        }
+        ESP_LOGI(TAG.data(), "NMEA Queue initialized!");
+    }
+    else
+    {
+        nmeaStream.reset();
+        ubxStream.reset();
     }
-    ESP_LOGI(TAG.data(), "NMEA Queue initialized!");
 
 
     ESP_LOGI(TAG.data(), "Initializing UART...");
@@ -242,12 +566,13 @@ esp_err_t NEO6M::start()
         return ESP_FAIL;
     }
 
+    const bool direct = cfg.ingest_mode == INGEST_DIRECT;
     const BaseType_t xReturned_2 = xTaskCreate(
-        uartTaskWrapper,
-        "uart_event_task",
-        cfg.uart_task_stack_size,
+        direct ? gpsTaskWrapper : uartTaskWrapper,
+        direct ? "gps_task" : "uart_event_task",
+        direct ? cfg.gps_task_stack_size : cfg.uart_task_stack_size,
         this,
-        cfg.uart_task_priority,
+        direct ? cfg.gps_task_priority : cfg.uart_task_priority,
         &uart_task_handle);
 
     if (xReturned_2 != pdPASS)
@@ -260,6 +585,10 @@ esp_err_t NEO6M::start()
     }
     ESP_LOGI(TAG.data(), "UART Initialized!");
 
+    ret = pps.start(cfg.pps_gpio);
+    if (ret != ESP_OK)
+        ESP_LOGW(TAG.data(), "Failed to start PPS capture, fixes are not pulse timed: %d", ret);
+
     running = true;
     ESP_LOGI(TAG.data(), "NEO6M GPS module started");
 
@@ -272,6 +601,8 @@ esp_err_t NEO6M::stop()
 
     running = false;
 
+    pps.stop();
+
     if (nmea_task_handle != nullptr)
     {
         // TODO!!! test deleted task delete
@@ -280,7 +611,11 @@ esp_err_t NEO6M::stop()
         nmea_task_handle = nullptr;
     }
 
-    vQueueDelete(nmeaQueue);
+    if (nmeaQueue != nullptr)
+    {
+        vQueueDelete(nmeaQueue);
+        nmeaQueue = nullptr;
+    }
 
     if (uart_task_handle != nullptr)
     {
@@ -9,32 +9,79 @@
 #include <hal/uart_types.h>
 
 #include "IGPSModule.h"
+#include "LatencyHistogram.h"
 #include "NMEAParser.h"
+#include "NMEAStream.h"
+#include "PPSCapture.h"
+#include "SentencePool.h"
+#include "UBXStream.h"
+#include "UART/IUARTPort.h"
 
 
 class NEO6M final : public IGPSModule
 {
 public:
+    enum ingest_mode_t
+    {
+        INGEST_PATTERN, // '\n' pattern interrupt, line is queued to the NMEA task
+        INGEST_STREAM,  // Bytes are decoded inline by the UART event task as they arrive
+        INGEST_DIRECT   // One task reads the UART driver buffer and decodes inline, no event queue
+    };
+
+    enum protocol_t
+    {
+        PROTOCOL_NMEA, // Receiver default output
+        PROTOCOL_UBX   // Receiver is switched to binary NAV messages on start, requires INGEST_STREAM or INGEST_DIRECT
+    };
+
     struct neo6m_config_t
     {
+        protocol_t protocol;
+        ingest_mode_t ingest_mode;
+        bool configure_receiver; // Probe and set up the receiver over UBX on start
         int uart_buffer_size;
         uart_port_t uart_port_num;
-        int uart_baud_rate;
+        int uart_baud_rate;        // Receiver speed before configuration
+        int uart_target_baud_rate; // Receiver speed after configuration
+        int nav_rate_hz;
         int uart_queue_size;
         int uart_txd;
         int uart_rxd;
         int uart_task_stack_size;
         int uart_task_priority;
+        int gps_task_stack_size; // INGEST_DIRECT task
+        int gps_task_priority;
         int nmea_task_stack_size;
         int nmea_task_priority;
+        int pps_gpio; // -1 if the time pulse is not wired
     };
 
 private:
     neo6m_config_t cfg;
     std::string TAG;
 
+    IUARTPort* port; // Not owned
+
+    static constexpr int UBX_ACK_TIMEOUT_MS = 500;
+    static constexpr int UBX_RETRIES = 3;
+
     char* uart_buffer;
     size_t uart_buffer_len;
+    int link_baud_rate;
+
+    // INGEST_PATTERN: lines are handed to the NMEA task by slot index
+    using sentence_pool_t = SentencePool<16, NMEAParser::MAX_SENTENCE_LEN + 8>;
+    static constexpr uint8_t NO_SLOT = 0xFF;
+    sentence_pool_t sentencePool;
+    uint8_t spare_slot;
+
+    // UART event to updateData() return, per message
+    LatencyHistogram latency;
+
+    PPSCapture pps;
+
+    NMEAStream nmeaStream;
+    UBXStream ubxStream;
 
     QueueHandle_t uartQueue;
     QueueHandle_t nmeaQueue;
@@ -44,15 +91,38 @@ private:
     bool running;
 
 public:
-    NEO6M();
+    explicit NEO6M(IUARTPort* port);
+    NEO6M(IUARTPort* port, const neo6m_config_t& config);
     ~NEO6M() override;
 
+    // Kconfig settings
+    static neo6m_config_t defaultConfig();
+
+    // UART event to stored data latency, microseconds
+    LatencyHistogram::Snapshot getLatency() const;
+    void resetLatency();
+
+    // Lines lost because the pool or the NMEA queue was full, or the line did not fit a slot
+    uint32_t getDroppedSentences() const;
+
 private:
     esp_err_t initUART();
-    esp_err_t removeUART() const;
+    esp_err_t removeUART();
+    static void gpsTaskWrapper(void* param);
+    _Noreturn void processDirect();
     static void uartTaskWrapper(void* param);
     _Noreturn void processUART();
-    void processPattern();
+    void processPattern(int64_t received);
+    void discardBytes(size_t size) const;
+    void processData(size_t size, int64_t received);
+    void processByte(uint8_t byte, GPSData* newData, int64_t received);
+    void deliver(const GPSData& newData, int64_t received);
+
+    esp_err_t sendUBX(uint8_t cls, uint8_t id, const uint8_t* payload, uint16_t length) const;
+    esp_err_t waitAck(uint8_t cls, uint8_t id);
+    esp_err_t sendUBXAck(uint8_t cls, uint8_t id, const uint8_t* payload, uint16_t length);
+    bool probeReceiver(int baud_rate);
+    esp_err_t configReceiver();
 
     static void nmeaTaskWrapper(void* param);
     _Noreturn void processNMEA();
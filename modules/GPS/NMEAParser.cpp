@@ -3,110 +3,315 @@
 //
 
 #include "NMEAParser.h"
+#include "NMEASchema.h"
 
+#include <array>
+#include <cstring>
 #include <esp_log.h>
 #include <esp_timer.h>
 
-std::vector<std::string> NMEAParser::split(const std::string& s, const std::string& delimiter)
+namespace
 {
-    std::vector<std::string> result;
+    using GPSData = IGPSModule::GPSData;
+
+    // $--GGA,hhmmss.ss,ddmm.mmmmm,N,dddmm.mmmmm,E,q,nn,h.hh,a.a,M,g.g,M,age,stn
+    using GGA = NMEASchema<
+        IGPSModule::CONTENT_POS | IGPSModule::CONTENT_ALT | IGPSModule::CONTENT_TIME,
+        NMEAWithFix<NMEATime<&GPSData::time_ms>>,
+        NMEAWithFix<NMEACoordinate<&GPSData::lat_e7, 2>>,
+        NMEAWithFix<NMEACoordinate<&GPSData::lon_e7, 3>>,
+        NMEARequired<NMEAFixQuality>,
+        NMEAWithFix<NMEAInt<&GPSData::satellites>>,
+        NMEAWithFix<NMEAFloat<&GPSData::hdop>>,
+        NMEAWithFix<NMEAFloat<&GPSData::alt>>,
+        NMEAWithFix<NMEAExpect<'M'>>,
+        NMEAOptional<NMEASkip<4>>>;
+
+    // $--RMC,hhmmss.ss,A,ddmm.mmmmm,N,dddmm.mmmmm,E,knots,course,ddmmyy,mv,mvE,mode
+    using RMC = NMEASchema<
+        IGPSModule::CONTENT_POS | IGPSModule::CONTENT_VEL | IGPSModule::CONTENT_TIME | IGPSModule::CONTENT_DATE,
+        NMEAWithFix<NMEATime<&GPSData::time_ms>>,
+        NMEARequired<NMEAStatus<'A'>>,
+        NMEAWithFix<NMEACoordinate<&GPSData::lat_e7, 2>>,
+        NMEAWithFix<NMEACoordinate<&GPSData::lon_e7, 3>>,
+        NMEAWithFix<NMEAFloat<&GPSData::spd, 463, 900>>, // knots -> m/s
+        NMEAOptional<NMEAFloat<&GPSData::hdg>>,           // empty while not moving
+        NMEAWithFix<NMEADate>,
+        NMEAOptional<NMEASkip<3>>>;
+
+    // $--VTG,course,T,course,M,knots,N,kph,K,mode
+    using VTG = NMEASchema<
+        IGPSModule::CONTENT_VEL,
+        NMEAOptional<NMEAFloat<&GPSData::hdg>>,
+        NMEAOptional<NMEAExpect<'T'>>,
+        NMEAOptional<NMEASkip<4>>,
+        NMEAWithFix<NMEAFloat<&GPSData::spd, 5, 18>>, // km/h -> m/s
+        NMEAWithFix<NMEAExpect<'K'>>,
+        NMEARequired<NMEAMode>>;
+
+    // $--GLL,ddmm.mmmmm,N,dddmm.mmmmm,E,hhmmss.ss,A,mode
+    using GLL = NMEASchema<
+        IGPSModule::CONTENT_POS | IGPSModule::CONTENT_TIME,
+        NMEAWithFix<NMEACoordinate<&GPSData::lat_e7, 2>>,
+        NMEAWithFix<NMEACoordinate<&GPSData::lon_e7, 3>>,
+        NMEAWithFix<NMEATime<&GPSData::time_ms>>,
+        NMEARequired<NMEAStatus<'A'>>,
+        NMEAOptional<NMEASkip<>>>;
+
+    // $--GSA,M,f,prn x12,pdop,hdop,vdop
+    using GSA = NMEASchema<
+        IGPSModule::CONTENT_DOP,
+        NMEARequired<NMEASkip<>>,
+        NMEARequired<NMEAFixType>,
+        NMEAOptional<NMEAUsedPrns>,
+        NMEAWithFix<NMEAFloat<&GPSData::pdop>>,
+        NMEAWithFix<NMEAFloat<&GPSData::hdop>>,
+        NMEAWithFix<NMEAFloat<&GPSData::vdop>>>;
+
+    // $--GSV,total,index,in_view,{prn,elevation,azimuth,snr} x1..4
+    using GSV = NMEASchema<
+        IGPSModule::CONTENT_SATS,
+        NMEARequired<NMEAInt<&GPSData::gsv_total>>,
+        NMEARequired<NMEAInt<&GPSData::gsv_index>>,
+        NMEARequired<NMEAInt<&GPSData::in_view>>,
+        NMEAOptional<NMEASatellite<0>>,
+        NMEAOptional<NMEASatellite<1>>,
+        NMEAOptional<NMEASatellite<2>>,
+        NMEAOptional<NMEASatellite<3>>>;
+
+    // $--TXT,total,index,type,text
+    using TXT = NMEASchema<
+        0,
+        NMEARequired<NMEASkip<3>>,
+        NMEAOptional<NMEAText<&GPSData::text>>>;
+}
+
+std::string_view NMEAParser::trim(std::string_view str)
+{
+    constexpr std::string_view chars = " \t\n\r\f\v";
 
-    if (delimiter.empty())
+    const size_t start = str.find_first_not_of(chars);
+    if (start == std::string_view::npos)
     {
-        if (!s.empty())
+        return {};
+    }
+
+    const size_t end = str.find_last_not_of(chars);
+
+    return str.substr(start, end - start + 1);
+}
+
+bool NMEAParser::tokenize(std::string_view body, Fields* fields)
+{
+    fields->count = 0;
+
+    size_t start = 0;
+    while (true)
+    {
+        if (fields->count == MAX_FIELDS) return false;
+
+        const size_t end = body.find(',', start);
+        if (end == std::string_view::npos)
         {
-            result.push_back(s);
+            fields->token[fields->count++] = body.substr(start);
+            return true;
         }
-        return result;
+
+        fields->token[fields->count++] = body.substr(start, end - start);
+        start = end + 1;
     }
+}
 
-    size_t start = 0;
-    size_t end = s.find(delimiter);
+void NMEAParser::copyText(std::string_view str, char* dst, size_t size)
+{
+    const size_t len = str.length() < size - 1 ? str.length() : size - 1;
+    memcpy(dst, str.data(), len);
+    dst[len] = '\0';
+}
+
+bool NMEAParser::parseHex(const char c, uint8_t* out)
+{
+    if (c >= '0' && c <= '9') *out = c - '0';
+    else if (c >= 'A' && c <= 'F') *out = c - 'A' + 10;
+    else if (c >= 'a' && c <= 'f') *out = c - 'a' + 10;
+    else return false;
+    return true;
+}
 
-    while (end != std::string::npos)
+bool NMEAParser::parseFixed(std::string_view str, const int decimals, int32_t* out)
+{
+    if (str.empty()) return false;
+
+    bool negative = false;
+    if (str[0] == '-' || str[0] == '+')
     {
-        result.push_back(s.substr(start, end - start));
-        start = end + delimiter.length();
-        end = s.find(delimiter, start);
+        negative = str[0] == '-';
+        str.remove_prefix(1);
     }
 
-    if (start <= s.length())
+    // At most 9 integer digits and `decimals` fraction digits, extra fraction digits are truncated
+    int64_t value = 0;
+    int integer_digits = 0;
+    int fraction_digits = -1;
+    for (const char c : str)
     {
-        result.push_back(s.substr(start));
+        if (c == '.' && fraction_digits < 0)
+        {
+            fraction_digits = 0;
+            continue;
+        }
+        if (c < '0' || c > '9') return false;
+        if (fraction_digits < 0)
+        {
+            if (++integer_digits > 9) return false;
+        }
+        else if (fraction_digits == decimals) continue;
+        else fraction_digits++;
+        value = value * 10 + (c - '0');
     }
+    if (integer_digits == 0 && fraction_digits <= 0) return false;
 
-    return result;
+    for (int i = fraction_digits < 0 ? 0 : fraction_digits; i < decimals; i++)
+        value *= 10;
+    if (value > INT32_MAX) return false;
+
+    *out = static_cast<int32_t>(negative ? -value : value);
+    return true;
 }
 
-std::string NMEAParser::replace(const std::string& str, const std::string& old_str, const std::string& new_str)
+bool NMEAParser::parseFloat(std::string_view str, float* out)
 {
-    if (str.empty() || old_str.empty())
+    static constexpr float scale[] = {1.0f, 1e-1f, 1e-2f, 1e-3f, 1e-4f, 1e-5f};
+
+    // Keep as many fraction digits as fit into the fixed point range
+    for (int decimals = 5; decimals >= 0; decimals--)
     {
-        return str;
+        int32_t value;
+        if (parseFixed(str, decimals, &value))
+        {
+            *out = static_cast<float>(value) * scale[decimals];
+            return true;
+        }
+        if (str.find('.') == std::string_view::npos) return false;
     }
+    return false;
+}
 
-    std::string result = str;
-    size_t pos = 0;
+bool NMEAParser::parseDigits(std::string_view str, int* out)
+{
+    // Up to 9 digits always fit into int
+    if (str.empty() || str.length() > 9) return false;
 
-    while ((pos = result.find(old_str, pos)) != std::string::npos)
+    int value = 0;
+    for (const char c : str)
     {
-        result.replace(pos, old_str.length(), new_str);
-        pos += new_str.length();
+        if (c < '0' || c > '9') return false;
+        value = value * 10 + (c - '0');
     }
-
-    return result;
+    *out = value;
+    return true;
 }
 
-std::string NMEAParser::trim(const std::string& str, const std::string& chars = " \t\n\r\f\v") {
-    if (str.empty()) {
-        return str;
-    }
+bool NMEAParser::parseTime(std::string_view str, int32_t* out)
+{
+    // hhmmss[.sss], fraction digits past milliseconds are truncated
+    if (str.length() < 6 || (str.length() > 6 && str[6] != '.')) return false;
 
-    size_t start = str.find_first_not_of(chars);
-    if (start == std::string::npos) {
-        return "";
+    int hours, minutes, seconds;
+    if (!parseDigits(str.substr(0, 2), &hours) || !parseDigits(str.substr(2, 2), &minutes) ||
+        !parseDigits(str.substr(4, 2), &seconds))
+        return false;
+    if (hours > 23 || minutes > 59 || seconds > 60) return false;
+
+    int32_t milliseconds = 0;
+    if (str.length() > 7)
+    {
+        int fraction;
+        const std::string_view digits = str.substr(7);
+        if (!parseDigits(digits.substr(0, 3), &fraction)) return false;
+        for (size_t i = 3; i < digits.length(); i++)
+            if (digits[i] < '0' || digits[i] > '9') return false;
+        for (size_t i = digits.length(); i < 3; i++) fraction *= 10;
+        milliseconds = fraction;
     }
 
-    size_t end = str.find_last_not_of(chars);
+    *out = ((hours * 60 + minutes) * 60 + seconds) * 1000 + milliseconds;
+    return true;
+}
 
-    return str.substr(start, end - start + 1);
+bool NMEAParser::parseDate(std::string_view str, GPSData* result)
+{
+    // ddmmyy
+    int day, month, year;
+    if (str.length() != 6 || !parseDigits(str.substr(0, 2), &day) || !parseDigits(str.substr(2, 2), &month) ||
+        !parseDigits(str.substr(4, 2), &year))
+        return false;
+    if (day < 1 || day > 31 || month < 1 || month > 12) return false;
+
+    result->day = day;
+    result->month = month;
+    result->year = 2000 + year;
+    return true;
 }
 
-bool NMEAParser::checkIntegrity(const std::string& nmea)
+bool NMEAParser::parseCoordinate(std::string_view value, std::string_view hemisphere, const size_t degree_digits,
+                                 int32_t* out)
 {
-    size_t checksumPos = nmea.find('*');
-    if (checksumPos == std::string::npos || checksumPos + 1 >= nmea.length()) {
-        return false; // '*' не найден или нет символов после него
-    }
+    // (d)ddmm.mmmmm -> 1e-7 degrees
+    if (value.length() < degree_digits + 2 || hemisphere.length() != 1) return false;
 
-    std::string checksumStr = nmea.substr(checksumPos + 1);
+    int degrees;
+    if (!parseDigits(value.substr(0, degree_digits), &degrees)) return false;
 
-    if (checksumStr.empty() || checksumStr.length() > 2) {
+    int32_t minutes_e7;
+    const std::string_view minutes = value.substr(degree_digits);
+    if (minutes[0] == '-' || minutes[0] == '+' || !parseFixed(minutes, 7, &minutes_e7)) return false;
+    if (minutes_e7 >= 600000000) return false;
+
+    // Rounded minutes to degrees, max 180 * 1e7 still fits into int32
+    const int32_t result = degrees * 10000000 + (minutes_e7 + 30) / 60;
+    if (result > static_cast<int32_t>(degree_digits == 2 ? 900000000 : 1800000000)) return false;
+
+    switch (hemisphere[0])
+    {
+    case 'N':
+    case 'E':
+        *out = result;
+        return true;
+    case 'S':
+    case 'W':
+        *out = -result;
+        return true;
+    default:
         return false;
     }
+}
 
-    for (char c : checksumStr) {
-        if (!isxdigit(c)) {
-            return false;
-        }
+bool NMEAParser::checkIntegrity(std::string_view nmea)
+{
+    const size_t checksumPos = nmea.find('*');
+    if (nmea.empty() || nmea[0] != '$' || checksumPos == std::string_view::npos ||
+        checksumPos + 3 != nmea.length())
+    {
+        return false; // '*' не найден или после него не два символа
     }
 
-    unsigned long receivedChecksum;
-    try {
-        receivedChecksum = std::stoul(checksumStr, nullptr, 16);
-    } catch (const std::exception&) {
+    uint8_t high, low;
+    if (!parseHex(nmea[checksumPos + 1], &high) || !parseHex(nmea[checksumPos + 2], &low))
+    {
         return false;
     }
+    const uint8_t receivedChecksum = high << 4 | low;
 
-    unsigned int calculatedChecksum = 0;
+    uint8_t calculatedChecksum = 0;
     for (size_t i = 1; i < checksumPos; ++i) {
         calculatedChecksum ^= nmea[i];
     }
 
-    return calculatedChecksum == static_cast<unsigned char>(receivedChecksum);
+    return calculatedChecksum == receivedChecksum;
 }
 
-NMEAParser::GPSData NMEAParser::parse(std::string nmea)
+NMEAParser::GPSData NMEAParser::parse(std::string_view nmea)
 {
     NMEAParser::GPSData result = {};
     result.timestamp = esp_timer_get_time();
@@ -121,127 +326,54 @@ NMEAParser::GPSData NMEAParser::parse(std::string nmea)
     }
     result.checksum = true;
 
-    nmea = nmea.substr(1, nmea.length() - 4);
+    // Strip leading '$' and trailing "*hh"
+    const std::string_view body = nmea.substr(1, nmea.length() - 4);
 
     // Get split data
-    const auto tokens = split(nmea, ",");
-
-    if (tokens[0].length() != 5)
+    Fields tokens;
+    if (!tokenize(body, &tokens))
     {
         result.parse_error = true;
         return result;
     }
 
-    result.source = tokens[0].substr(0, 2);
-    result.type = tokens[0].substr(2, 3);
-
-    if (result.type == "GGA")
-    {
-        parseGGA(tokens, &result);
-    } else if (result.type == "RMC")
-    {
-        parseRMC(tokens, &result);
-    } else if (result.type == "TXT")
-    {
-        parseTXT(tokens, &result);
-    } else
-    {
-        result.ignore = true;
-    }
+    decode(tokens, &result);
 
     return result;
 }
 
-void NMEAParser::parseGGA(const std::vector<std::string>& tokens, GPSData* result)
+void NMEAParser::decode(const Fields& tokens, GPSData* result)
 {
-    if (tokens.size() == 15)
+    if (tokens.count == 0 || tokens.token[0].length() != 5)
     {
-        if (tokens[6] == "1") result->valid = true;
-        else return;
-        result->time = std::stof(tokens[1]);
-        result->lat = parseLatitude(tokens[2], tokens[3][0]);
-        result->lon = parseLongitude(tokens[4], tokens[5][0]);
-        result->satellites = std::stoi(tokens[7]);
-        result->hdop = std::stof(tokens[8]);
-        //TODO!
-        if (tokens[10] == "M") result->alt = std::stof(tokens[9]);
-        else result->valid = false;
-    } else {
         result->parse_error = true;
+        return;
     }
-}
-
-void NMEAParser::parseRMC(const std::vector<std::string>& tokens, GPSData* result)
-{
-    if (tokens.size() == 13)
-    {
-        if (tokens[2] == "A") result->valid = true;
-        else return;
-        result->time = std::stof(tokens[1]);
-        result->lat = parseLatitude(tokens[3], tokens[4][0]);
-        result->lon = parseLongitude(tokens[5], tokens[6][0]);
-        result->spd = std::stof(tokens[7]) / 1.944f;
-        if (!tokens[8].empty())
-            result->hdg = std::stof(tokens[8]);
-        else
-            result->hdg = 0;
-        result->date = std::stof(tokens[9]);
-    } else {
-        result->parse_error = true;
-    }
-}
-
 
+    const std::string_view header = tokens.token[0];
+    result->source = NMEASentence::talker(header.substr(0, 2));
+    result->type = NMEASentence::type(header.substr(2, 3));
 
-void NMEAParser::parseTXT(const std::vector<std::string>& tokens, GPSData* result)
-{
-    if (tokens.size() == 5)
+    // Jump table indexed by sentence type, unknown and unsupported types are ignored
+    using Handler = void (*)(const Fields&, GPSData*);
+    static constexpr auto handlers = []
     {
-        result->text = tokens[4];
-    } else {
-        result->parse_error = true;
-    }
-}
-
-double NMEAParser::parseLatitude(const std::string& lat, const char& direction) {
-    // Проверяем длину строки
-    if (lat.length() < 9) return 0.0;
-
-    // Извлекаем градусы (первые два символа)
-    double degrees = std::stod(lat.substr(0, 2));
-
-    // Извлекаем минуты (остальная часть)
-    double minutes = std::stod(lat.substr(2));
-
-    // Преобразуем в десятичные градусы
-    double decimal_degrees = degrees + (minutes / 60.0);
-
-    // Если направление южное, меняем знак
-    if (direction == 'S') {
-        decimal_degrees = -decimal_degrees;
-    }
-
-    return decimal_degrees;
+        std::array<Handler, static_cast<size_t>(NMEAType::COUNT)> table = {};
+        table.fill(&NMEAParser::parseIgnored);
+        table[static_cast<size_t>(NMEAType::GGA)] = &GGA::decode;
+        table[static_cast<size_t>(NMEAType::RMC)] = &RMC::decode;
+        table[static_cast<size_t>(NMEAType::VTG)] = &VTG::decode;
+        table[static_cast<size_t>(NMEAType::GLL)] = &GLL::decode;
+        table[static_cast<size_t>(NMEAType::GSA)] = &GSA::decode;
+        table[static_cast<size_t>(NMEAType::GSV)] = &GSV::decode;
+        table[static_cast<size_t>(NMEAType::TXT)] = &TXT::decode;
+        return table;
+    }();
+
+    handlers[static_cast<size_t>(result->type)](tokens, result);
 }
 
-double NMEAParser::parseLongitude(const std::string& lon, const char& direction) {
-    // Проверяем длину строки
-    if (lon.length() < 10) return 0.0;
-
-    // Извлекаем градусы (первые три символа)
-    double degrees = std::stod(lon.substr(0, 3));
-
-    // Извлекаем минуты (остальная часть)
-    double minutes = std::stod(lon.substr(3));
-
-    // Преобразуем в десятичные градусы
-    double decimal_degrees = degrees + (minutes / 60.0);
-
-    // Если направление западное, меняем знак
-    if (direction == 'W') {
-        decimal_degrees = -decimal_degrees;
-    }
-
-    return decimal_degrees;
+void NMEAParser::parseIgnored(const Fields&, GPSData* result)
+{
+    result->ignore = true;
 }
-
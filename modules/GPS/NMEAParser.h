@@ -5,31 +5,51 @@
 #ifndef NMEAPARSER_H
 #define NMEAPARSER_H
 
-#include <string>
-#include <vector>
+#include <cstddef>
+#include <string_view>
 
 #include "IGPSModule.h"
 
 
 class NMEAParser {
+public:
+    // NMEA 0183 limits a sentence to 82 characters, GSV is the widest one with 20 fields
+    static constexpr size_t MAX_SENTENCE_LEN = 82;
+    static constexpr size_t MAX_FIELDS = 24;
+
+    // Sentence body split in place: every token points into the caller's buffer
+    struct Fields
+    {
+        std::string_view token[MAX_FIELDS];
+        size_t count = 0;
+    };
+
+private:
     using GPSData = IGPSModule::GPSData;
 
-    // String functions
-    static std::vector<std::string> split(const std::string& s, const std::string& delimiter);
-    static std::string replace(const std::string& str, const std::string& old_str, const std::string& new_str);
-    static std::string trim(const std::string& str, const std::string& chars);
-
-    static bool checkIntegrity(const std::string& nmea);
+    static bool tokenize(std::string_view body, Fields* fields);
+    static bool checkIntegrity(std::string_view nmea);
 
-    // TODO: NOT COMPLETED
-    static void parseGGA(const std::vector<std::string>& tokens, GPSData* result);
-    static void parseRMC(const std::vector<std::string>& tokens, GPSData* result);
-    static void parseTXT(const std::vector<std::string>& tokens, GPSData* result);
+    static void parseIgnored(const Fields& tokens, GPSData* result);
 
-    static double parseLongitude(const std::string& lon, const char& direction);
-    static double parseLatitude(const std::string& lat, const char& direction);
 public:
-    static GPSData parse(std::string nmea);
+    static GPSData parse(std::string_view nmea);
+    // Decodes an already verified and split sentence body (talker+type first)
+    static void decode(const Fields& tokens, GPSData* result);
+
+    // String functions
+    static std::string_view trim(std::string_view str);
+    static void copyText(std::string_view str, char* dst, size_t size);
+
+    // Number functions (integer only: no exceptions, no allocations, no doubles)
+    static bool parseHex(char c, uint8_t* out);
+    static bool parseDigits(std::string_view str, int* out); // At most 9 digits
+    static bool parseFixed(std::string_view str, int decimals, int32_t* out);
+    static bool parseFloat(std::string_view str, float* out);
+    static bool parseTime(std::string_view str, int32_t* out);
+    static bool parseDate(std::string_view str, GPSData* result);
+    static bool parseCoordinate(std::string_view value, std::string_view hemisphere, size_t degree_digits,
+                                int32_t* out);
 };
 
 
@@ -0,0 +1,296 @@
+//
+// Created by stikper on 21.04.25.
+//
+
+#ifndef NMEASCHEMA_H
+#define NMEASCHEMA_H
+
+#include <cstddef>
+#include <string_view>
+#include <type_traits>
+
+#include "IGPSModule.h"
+#include "NMEAParser.h"
+
+
+// Declarative NMEA sentence description.
+// A sentence is a list of typed fields, NMEASchema<...>::decode is generated from it
+// and walks the split tokens once, left to right.
+
+enum class NMEAPresence : uint8_t
+{
+    REQUIRED, // Empty field is a parse error
+    WITH_FIX, // Empty field is a parse error only if the sentence reports a valid fix
+    OPTIONAL  // Empty or missing field is skipped
+};
+
+struct NMEACursor
+{
+    const NMEAParser::Fields& tokens;
+    size_t index;
+    bool missing; // Some WITH_FIX field was empty
+};
+
+
+// Field = token decoder + presence policy
+template <typename Decoder, NMEAPresence Presence>
+struct NMEAField
+{
+    using GPSData = IGPSModule::GPSData;
+
+    static bool decode(NMEACursor& cursor, GPSData* result)
+    {
+        const std::string_view* tokens = cursor.tokens.token + cursor.index;
+        const bool present = cursor.index + Decoder::TOKENS <= cursor.tokens.count;
+        cursor.index += Decoder::TOKENS;
+
+        bool empty = true;
+        if (present)
+            for (size_t i = 0; i < Decoder::TOKENS; i++)
+                empty = empty && tokens[i].empty();
+
+        if (empty)
+        {
+            if constexpr (Presence == NMEAPresence::REQUIRED) return false;
+            if constexpr (Presence == NMEAPresence::WITH_FIX) cursor.missing = true;
+            return true;
+        }
+        return Decoder::decode(tokens, result);
+    }
+};
+
+template <typename Decoder>
+using NMEARequired = NMEAField<Decoder, NMEAPresence::REQUIRED>;
+template <typename Decoder>
+using NMEAWithFix = NMEAField<Decoder, NMEAPresence::WITH_FIX>;
+template <typename Decoder>
+using NMEAOptional = NMEAField<Decoder, NMEAPresence::OPTIONAL>;
+
+// Content = IGPSModule::content_t flags of the decoded sentence
+template <uint8_t Content, typename... Fields>
+struct NMEASchema
+{
+    using GPSData = IGPSModule::GPSData;
+
+    static void decode(const NMEAParser::Fields& tokens, GPSData* result)
+    {
+        result->content = Content;
+
+        // Token 0 is the talker+type header
+        NMEACursor cursor{tokens, 1, false};
+        if (!(Fields::decode(cursor, result) && ...) || (result->valid && cursor.missing))
+        {
+            result->valid = false;
+            result->parse_error = true;
+        }
+    }
+};
+
+
+// Token decoders
+
+template <size_t N = 1>
+struct NMEASkip
+{
+    static constexpr size_t TOKENS = N;
+
+    static bool decode(const std::string_view*, IGPSModule::GPSData*)
+    {
+        return true;
+    }
+};
+
+template <auto Member>
+struct NMEATime
+{
+    static constexpr size_t TOKENS = 1;
+
+    static bool decode(const std::string_view* tokens, IGPSModule::GPSData* result)
+    {
+        return NMEAParser::parseTime(tokens[0], &(result->*Member));
+    }
+};
+
+struct NMEADate
+{
+    static constexpr size_t TOKENS = 1;
+
+    static bool decode(const std::string_view* tokens, IGPSModule::GPSData* result)
+    {
+        return NMEAParser::parseDate(tokens[0], result);
+    }
+};
+
+// Value + hemisphere pair
+template <auto Member, size_t DegreeDigits>
+struct NMEACoordinate
+{
+    static constexpr size_t TOKENS = 2;
+
+    static bool decode(const std::string_view* tokens, IGPSModule::GPSData* result)
+    {
+        return NMEAParser::parseCoordinate(tokens[0], tokens[1], DegreeDigits, &(result->*Member));
+    }
+};
+
+// Decimal value multiplied by Num/Den (unit conversion)
+template <auto Member, int Num = 1, int Den = 1>
+struct NMEAFloat
+{
+    static constexpr size_t TOKENS = 1;
+
+    static bool decode(const std::string_view* tokens, IGPSModule::GPSData* result)
+    {
+        float value;
+        if (!NMEAParser::parseFloat(tokens[0], &value)) return false;
+        if constexpr (Num != Den) value = value * Num / Den;
+        result->*Member = value;
+        return true;
+    }
+};
+
+template <auto Member>
+struct NMEAInt
+{
+    static constexpr size_t TOKENS = 1;
+
+    static bool decode(const std::string_view* tokens, IGPSModule::GPSData* result)
+    {
+        int value;
+        if (!NMEAParser::parseDigits(tokens[0], &value)) return false;
+        result->*Member = static_cast<std::remove_reference_t<decltype(result->*Member)>>(value);
+        return true;
+    }
+};
+
+// Constant field, e.g. units
+template <char Expected>
+struct NMEAExpect
+{
+    static constexpr size_t TOKENS = 1;
+
+    static bool decode(const std::string_view* tokens, IGPSModule::GPSData*)
+    {
+        return tokens[0].length() == 1 && tokens[0][0] == Expected;
+    }
+};
+
+// Status letter, sets GPSData::valid
+template <char Valid>
+struct NMEAStatus
+{
+    static constexpr size_t TOKENS = 1;
+
+    static bool decode(const std::string_view* tokens, IGPSModule::GPSData* result)
+    {
+        result->valid = tokens[0].length() == 1 && tokens[0][0] == Valid;
+        return tokens[0].length() == 1;
+    }
+};
+
+// GGA fix quality, sets GPSData::valid for GPS, DGPS, PPS and RTK fixes
+struct NMEAFixQuality
+{
+    static constexpr size_t TOKENS = 1;
+
+    static bool decode(const std::string_view* tokens, IGPSModule::GPSData* result)
+    {
+        int quality;
+        if (!NMEAParser::parseDigits(tokens[0], &quality)) return false;
+        result->valid = quality >= 1 && quality <= 5;
+        return true;
+    }
+};
+
+// GSA fix type, sets GPSData::valid for 2D and 3D fixes
+struct NMEAFixType
+{
+    static constexpr size_t TOKENS = 1;
+
+    static bool decode(const std::string_view* tokens, IGPSModule::GPSData* result)
+    {
+        int type;
+        if (!NMEAParser::parseDigits(tokens[0], &type) || type < 1 || type > 3) return false;
+        result->fix_type = type;
+        result->valid = type >= 2;
+        return true;
+    }
+};
+
+template <auto Member>
+struct NMEAText
+{
+    static constexpr size_t TOKENS = 1;
+
+    static bool decode(const std::string_view* tokens, IGPSModule::GPSData* result)
+    {
+        NMEAParser::copyText(tokens[0], result->*Member, sizeof(result->*Member));
+        return true;
+    }
+};
+
+// RMC/VTG/GLL mode indicator, sets GPSData::valid for autonomous and differential fixes
+struct NMEAMode
+{
+    static constexpr size_t TOKENS = 1;
+
+    static bool decode(const std::string_view* tokens, IGPSModule::GPSData* result)
+    {
+        result->valid = tokens[0] == "A" || tokens[0] == "D";
+        return tokens[0].length() == 1;
+    }
+};
+
+// GSA satellite ids used in solution, unused channels are empty
+struct NMEAUsedPrns
+{
+    static constexpr size_t TOKENS = 12;
+
+    static bool decode(const std::string_view* tokens, IGPSModule::GPSData* result)
+    {
+        for (size_t i = 0; i < TOKENS; i++)
+        {
+            if (tokens[i].empty()) continue;
+
+            int prn;
+            if (!NMEAParser::parseDigits(tokens[i], &prn) || prn > 255) return false;
+            result->used_prn[i] = prn;
+        }
+        return true;
+    }
+};
+
+// GSV satellite block: prn, elevation, azimuth, snr
+template <size_t Index>
+struct NMEASatellite
+{
+    static constexpr size_t TOKENS = 4;
+
+    static bool decode(const std::string_view* tokens, IGPSModule::GPSData* result)
+    {
+        IGPSModule::Satellite& sat = result->sats[Index];
+        int value;
+
+        if (!NMEAParser::parseDigits(tokens[0], &value) || value > 255) return false;
+        sat.prn = value;
+        if (!tokens[1].empty())
+        {
+            if (!NMEAParser::parseDigits(tokens[1], &value) || value > 90) return false;
+            sat.elevation = value;
+        }
+        if (!tokens[2].empty())
+        {
+            if (!NMEAParser::parseDigits(tokens[2], &value) || value > 359) return false;
+            sat.azimuth = value;
+        }
+        if (!tokens[3].empty())
+        {
+            if (!NMEAParser::parseDigits(tokens[3], &value) || value > 99) return false;
+            sat.snr = value;
+        }
+        return true;
+    }
+};
+
+
+#endif //NMEASCHEMA_H
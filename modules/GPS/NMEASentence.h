@@ -0,0 +1,163 @@
+//
+// Created by stikper on 14.04.25.
+//
+
+#ifndef NMEASENTENCE_H
+#define NMEASENTENCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+
+enum class NMEATalker : uint8_t
+{
+    UNKNOWN,
+    GP, // GPS
+    GL, // GLONASS
+    GA, // Galileo
+    GB, // BeiDou
+    BD, // BeiDou (legacy)
+    GQ, // QZSS
+    GN  // Combined GNSS
+};
+
+enum class NMEAType : uint8_t
+{
+    UNKNOWN,
+    GGA,
+    RMC,
+    TXT,
+    GSA,
+    GSV,
+    VTG,
+    GLL,
+    ZDA,
+    GNS,
+    GST,
+    GBS,
+    GRS,
+    DTM,
+    THS,
+    COUNT
+};
+
+
+// Perfect hash over all known sentence codes.
+// Multiplier is searched for at compile time, so adding a type to build() costs nothing at runtime.
+class NMEATypeTable
+{
+public:
+    static constexpr size_t BITS = 5;
+    static constexpr size_t SIZE = 1 << BITS;
+
+    uint32_t multiplier = 0;
+    uint32_t keys[SIZE] = {};
+    NMEAType types[SIZE] = {};
+
+    static constexpr uint32_t pack(const char a, const char b, const char c)
+    {
+        return static_cast<uint32_t>(static_cast<uint8_t>(a)) << 16 |
+            static_cast<uint32_t>(static_cast<uint8_t>(b)) << 8 |
+            static_cast<uint32_t>(static_cast<uint8_t>(c));
+    }
+
+    constexpr size_t bucket(const uint32_t key) const
+    {
+        return static_cast<uint32_t>(key * multiplier) >> (32 - BITS);
+    }
+
+    static constexpr NMEATypeTable build()
+    {
+        struct Code
+        {
+            char name[4];
+            NMEAType type;
+        };
+        constexpr Code codes[] = {
+            {"GGA", NMEAType::GGA}, {"RMC", NMEAType::RMC}, {"TXT", NMEAType::TXT}, {"GSA", NMEAType::GSA},
+            {"GSV", NMEAType::GSV}, {"VTG", NMEAType::VTG}, {"GLL", NMEAType::GLL}, {"ZDA", NMEAType::ZDA},
+            {"GNS", NMEAType::GNS}, {"GST", NMEAType::GST}, {"GBS", NMEAType::GBS}, {"GRS", NMEAType::GRS},
+            {"DTM", NMEAType::DTM}, {"THS", NMEAType::THS},
+        };
+
+        NMEATypeTable table;
+        uint32_t candidate = 0x9E3779B1;
+        for (int attempt = 0; attempt < 100000; attempt++)
+        {
+            table = {};
+            table.multiplier = candidate;
+
+            bool collision = false;
+            for (const auto& code : codes)
+            {
+                const uint32_t key = pack(code.name[0], code.name[1], code.name[2]);
+                const size_t index = table.bucket(key);
+                if (table.types[index] != NMEAType::UNKNOWN)
+                {
+                    collision = true;
+                    break;
+                }
+                table.keys[index] = key;
+                table.types[index] = code.type;
+            }
+            if (!collision) return table;
+
+            candidate = (candidate * 1664525u + 1013904223u) | 1u;
+        }
+
+        return {};
+    }
+};
+
+
+class NMEASentence
+{
+    static constexpr NMEATypeTable TYPE_TABLE = NMEATypeTable::build();
+    static_assert(TYPE_TABLE.multiplier != 0, "No collision-free hash for NMEA sentence codes");
+
+public:
+    // Three letter sentence code, e.g. "GGA"
+    static constexpr NMEAType type(const std::string_view code)
+    {
+        if (code.length() != 3) return NMEAType::UNKNOWN;
+
+        const uint32_t key = NMEATypeTable::pack(code[0], code[1], code[2]);
+        const size_t index = TYPE_TABLE.bucket(key);
+        return TYPE_TABLE.keys[index] == key ? TYPE_TABLE.types[index] : NMEAType::UNKNOWN;
+    }
+
+    // Two letter talker id, e.g. "GP"
+    static constexpr NMEATalker talker(const std::string_view code)
+    {
+        if (code.length() != 2) return NMEATalker::UNKNOWN;
+
+        switch (static_cast<uint16_t>(code[0] << 8 | code[1]))
+        {
+        case 'G' << 8 | 'P': return NMEATalker::GP;
+        case 'G' << 8 | 'L': return NMEATalker::GL;
+        case 'G' << 8 | 'A': return NMEATalker::GA;
+        case 'G' << 8 | 'B': return NMEATalker::GB;
+        case 'B' << 8 | 'D': return NMEATalker::BD;
+        case 'G' << 8 | 'Q': return NMEATalker::GQ;
+        case 'G' << 8 | 'N': return NMEATalker::GN;
+        default: return NMEATalker::UNKNOWN;
+        }
+    }
+
+    static constexpr const char* name(const NMEAType type)
+    {
+        constexpr const char* names[] = {
+            "UNKNOWN", "GGA", "RMC", "TXT", "GSA", "GSV", "VTG", "GLL", "ZDA", "GNS", "GST", "GBS", "GRS", "DTM", "THS"
+        };
+        static_assert(sizeof(names) / sizeof(names[0]) == static_cast<size_t>(NMEAType::COUNT));
+        return type < NMEAType::COUNT ? names[static_cast<size_t>(type)] : names[0];
+    }
+};
+
+static_assert(NMEASentence::type("GGA") == NMEAType::GGA);
+static_assert(NMEASentence::type("THS") == NMEAType::THS);
+static_assert(NMEASentence::type("XYZ") == NMEAType::UNKNOWN);
+
+
+#endif //NMEASENTENCE_H
@@ -0,0 +1,130 @@
+//
+// Created by stikper on 02.04.25.
+//
+
+#include "NMEAStream.h"
+
+#include <esp_timer.h>
+
+NMEAStream::NMEAStream()
+{
+    overflows = 0;
+    reset();
+}
+
+void NMEAStream::reset()
+{
+    state = State::WAIT_START;
+    length = 0;
+    field_start = 0;
+    checksum = 0;
+    received_checksum = 0;
+    fields.count = 0;
+}
+
+bool NMEAStream::closeField()
+{
+    if (fields.count == NMEAParser::MAX_FIELDS) return false;
+
+    fields.token[fields.count++] = std::string_view(buffer + field_start, length - field_start);
+    return true;
+}
+
+bool NMEAStream::feed(const char c, GPSData* result)
+{
+    // Start of sentence always resynchronizes the decoder
+    if (c == '$')
+    {
+        reset();
+        state = State::BODY;
+        return false;
+    }
+
+    switch (state)
+    {
+    case State::WAIT_START:
+        return false;
+
+    case State::BODY:
+        if (c == '*')
+        {
+            if (!closeField())
+            {
+                overflows++;
+                reset();
+                return false;
+            }
+            state = State::CHECKSUM_HI;
+            return false;
+        }
+        if (c == '\r' || c == '\n' || length == sizeof(buffer))
+        {
+            // Truncated or oversized sentence
+            overflows++;
+            reset();
+            return false;
+        }
+
+        checksum ^= c;
+        if (c == ',')
+        {
+            if (!closeField())
+            {
+                overflows++;
+                reset();
+                return false;
+            }
+            // Separator is not a part of any field
+            buffer[length++] = c;
+            field_start = length;
+            return false;
+        }
+        buffer[length++] = c;
+        return false;
+
+    case State::CHECKSUM_HI:
+        {
+            uint8_t digit;
+            if (!NMEAParser::parseHex(c, &digit))
+            {
+                reset();
+                return false;
+            }
+            received_checksum = digit << 4;
+            state = State::CHECKSUM_LO;
+            return false;
+        }
+
+    case State::CHECKSUM_LO:
+        {
+            uint8_t digit;
+            if (!NMEAParser::parseHex(c, &digit))
+            {
+                reset();
+                return false;
+            }
+            received_checksum |= digit;
+
+            *result = {};
+            result->timestamp = esp_timer_get_time();
+            result->checksum = received_checksum == checksum;
+            if (result->checksum)
+                NMEAParser::decode(fields, result);
+
+            state = State::WAIT_START;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool NMEAStream::idle() const
+{
+    return state == State::WAIT_START;
+}
+
+uint32_t NMEAStream::getOverflows() const
+{
+    return overflows;
+}
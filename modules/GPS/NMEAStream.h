@@ -0,0 +1,55 @@
+//
+// Created by stikper on 02.04.25.
+//
+
+#ifndef NMEASTREAM_H
+#define NMEASTREAM_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "IGPSModule.h"
+#include "NMEAParser.h"
+
+
+// Resumable byte-at-a-time NMEA decoder.
+// Checksum and field boundaries are computed while bytes arrive,
+// so a sentence is decoded as soon as its "*hh" trailer is received.
+class NMEAStream
+{
+    using GPSData = IGPSModule::GPSData;
+
+    enum class State : uint8_t
+    {
+        WAIT_START,
+        BODY,
+        CHECKSUM_HI,
+        CHECKSUM_LO
+    };
+
+    State state;
+    char buffer[NMEAParser::MAX_SENTENCE_LEN];
+    size_t length;
+    size_t field_start;
+    uint8_t checksum;
+    uint8_t received_checksum;
+    NMEAParser::Fields fields;
+
+    uint32_t overflows;
+
+    bool closeField();
+
+public:
+    NMEAStream();
+
+    void reset();
+
+    // Returns true when a complete sentence has been decoded into result
+    bool feed(char c, GPSData* result);
+
+    bool idle() const;
+    uint32_t getOverflows() const;
+};
+
+
+#endif //NMEASTREAM_H
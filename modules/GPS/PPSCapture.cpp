@@ -0,0 +1,105 @@
+//
+// Created by stikper on 10.05.25.
+//
+
+#include "PPSCapture.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+
+
+PPSCapture::PPSCapture()
+{
+    TAG = "PPS";
+    gpio = GPIO_NUM_NC;
+    for (auto& edge : edges)
+        edge = 0;
+    count.store(0, std::memory_order_relaxed);
+}
+
+PPSCapture::~PPSCapture()
+{
+    stop();
+}
+
+void IRAM_ATTR PPSCapture::isrHandler(void* arg)
+{
+    auto* pps = static_cast<PPSCapture*>(arg);
+
+    const int64_t now = esp_timer_get_time();
+    const uint32_t n = pps->count.load(std::memory_order_relaxed);
+    pps->edges[n % EDGES] = now;
+    pps->count.store(n + 1, std::memory_order_release);
+}
+
+esp_err_t PPSCapture::start(const int gpio_num)
+{
+    if (gpio_num < 0) return ESP_OK;
+    if (enabled()) return ESP_OK;
+
+    const gpio_config_t io_config = {
+        .pin_bit_mask = 1ULL << gpio_num,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_ENABLE,
+        .intr_type = GPIO_INTR_POSEDGE
+    };
+    esp_err_t ret = gpio_config(&io_config);
+    if (ret != ESP_OK) return ret;
+
+    // Service may already be installed by another module
+    ret = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) return ret;
+
+    count.store(0, std::memory_order_relaxed);
+    ret = gpio_isr_handler_add(static_cast<gpio_num_t>(gpio_num), isrHandler, this);
+    if (ret != ESP_OK) return ret;
+
+    gpio = static_cast<gpio_num_t>(gpio_num);
+    ESP_LOGI(TAG.data(), "Capturing time pulse on GPIO %d", gpio_num);
+    return ESP_OK;
+}
+
+esp_err_t PPSCapture::stop()
+{
+    if (!enabled()) return ESP_OK;
+
+    const esp_err_t ret = gpio_isr_handler_remove(gpio);
+    gpio = GPIO_NUM_NC;
+    return ret;
+}
+
+bool PPSCapture::enabled() const
+{
+    return gpio != GPIO_NUM_NC;
+}
+
+uint32_t PPSCapture::getCount() const
+{
+    return count.load(std::memory_order_acquire);
+}
+
+int64_t PPSCapture::resolve(const int32_t time_ms, const int64_t received) const
+{
+    int64_t latest[2];
+    uint32_t n;
+    do
+    {
+        n = count.load(std::memory_order_acquire);
+        if (n == 0) return -1;
+        latest[0] = edges[(n - 1) % EDGES];
+        latest[1] = n > 1 ? edges[(n - 2) % EDGES] : -1;
+    }
+    while (count.load(std::memory_order_acquire) - n >= EDGES - 2); // Edges overwritten while copying
+
+    // Epoch is output after its instant and within a second of it, late epochs may already see the next edge
+    const int64_t offset = static_cast<int64_t>(time_ms % 1000) * 1000;
+    for (const int64_t edge : latest)
+    {
+        if (edge < 0) break;
+
+        const int64_t instant = edge + offset;
+        if (instant <= received && received - instant < 1000000) return instant;
+    }
+    return -1;
+}
@@ -0,0 +1,45 @@
+//
+// Created by stikper on 10.05.25.
+//
+
+#ifndef PPSCAPTURE_H
+#define PPSCAPTURE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <driver/gpio.h>
+#include <esp_attr.h>
+
+
+// Time pulse capture: the GPIO interrupt latches esp_timer at every rising PPS edge.
+// The receiver aligns the edge to the top of the UTC second, so the acquisition instant of any
+// epoch is the matching edge plus the sub-second part of its UTC time.
+class PPSCapture
+{
+    static constexpr size_t EDGES = 4; // Power of two
+
+    std::string TAG;
+
+    gpio_num_t gpio;
+    int64_t edges[EDGES];
+    std::atomic<uint32_t> count; // Edges captured, written only by the ISR
+
+    static void IRAM_ATTR isrHandler(void* arg);
+
+public:
+    PPSCapture();
+    ~PPSCapture();
+
+    esp_err_t start(int gpio_num);
+    esp_err_t stop();
+    bool enabled() const;
+
+    uint32_t getCount() const;
+
+    // esp_timer time of UTC time_ms of an epoch received at received, -1 if no edge matches
+    int64_t resolve(int32_t time_ms, int64_t received) const;
+};
+
+
+#endif //PPSCAPTURE_H
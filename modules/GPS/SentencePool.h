@@ -0,0 +1,116 @@
+//
+// Created by stikper on 05.05.25.
+//
+
+#ifndef SENTENCEPOOL_H
+#define SENTENCEPOOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+
+// Preallocated sentence slots handed between two tasks by index.
+// Free slots are kept in a single-producer single-consumer index ring:
+// only the reading task acquires and only the parsing task releases, so no locks are needed.
+template <size_t Slots, size_t SlotSize>
+class SentencePool
+{
+    static_assert(Slots > 0 && Slots < 256, "Slot index must fit into uint8_t");
+
+    struct Slot
+    {
+        int64_t timestamp; // Reception of the line
+        size_t length;
+        char data[SlotSize];
+    };
+
+    Slot slots[Slots];
+
+    uint8_t free_ring[Slots];
+    std::atomic<uint32_t> free_head; // Next free slot to acquire
+    std::atomic<uint32_t> free_tail; // Next position to release into
+
+    std::atomic<uint32_t> drops;
+
+public:
+    static constexpr size_t SLOTS = Slots;
+    static constexpr size_t SLOT_SIZE = SlotSize;
+
+    SentencePool()
+    {
+        drops.store(0, std::memory_order_relaxed);
+        reset();
+    }
+
+    // Returns all slots to the free ring, only while neither task is running
+    void reset()
+    {
+        for (size_t i = 0; i < Slots; i++)
+        {
+            slots[i].timestamp = 0;
+            slots[i].length = 0;
+            free_ring[i] = static_cast<uint8_t>(i);
+        }
+        free_head.store(0, std::memory_order_relaxed);
+        free_tail.store(Slots, std::memory_order_relaxed);
+    }
+
+    // Reading task: returns false if every slot is in flight
+    bool acquire(uint8_t* index)
+    {
+        const uint32_t head = free_head.load(std::memory_order_relaxed);
+        if (head == free_tail.load(std::memory_order_acquire)) return false;
+
+        *index = free_ring[head % Slots];
+        free_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Parsing task only
+    void release(const uint8_t index)
+    {
+        const uint32_t tail = free_tail.load(std::memory_order_relaxed);
+        free_ring[tail % Slots] = index;
+        free_tail.store(tail + 1, std::memory_order_release);
+    }
+
+    char* data(const uint8_t index)
+    {
+        return slots[index].data;
+    }
+
+    void setLength(const uint8_t index, const size_t length)
+    {
+        slots[index].length = length < SlotSize ? length : SlotSize;
+    }
+
+    void setTimestamp(const uint8_t index, const int64_t timestamp)
+    {
+        slots[index].timestamp = timestamp;
+    }
+
+    int64_t getTimestamp(const uint8_t index) const
+    {
+        return slots[index].timestamp;
+    }
+
+    std::string_view view(const uint8_t index) const
+    {
+        return {slots[index].data, slots[index].length};
+    }
+
+    void drop()
+    {
+        drops.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint32_t getDrops() const
+    {
+        return drops.load(std::memory_order_relaxed);
+    }
+};
+
+
+#endif //SENTENCEPOOL_H
@@ -0,0 +1,336 @@
+//
+// Created by stikper on 28.04.25.
+//
+
+#include "UBXStream.h"
+
+#include <cmath>
+#include <cstring>
+#include <esp_timer.h>
+
+namespace
+{
+    // UBX is little-endian
+    uint16_t u2(const uint8_t* p)
+    {
+        return static_cast<uint16_t>(p[0] | p[1] << 8);
+    }
+
+    uint32_t u4(const uint8_t* p)
+    {
+        return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+            static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+    }
+
+    int32_t i4(const uint8_t* p)
+    {
+        return static_cast<int32_t>(u4(p));
+    }
+
+    constexpr int32_t DAY_MS = 86400000;
+}
+
+UBXStream::UBXStream()
+{
+    fix_ok = false;
+    fix_itow = UINT32_MAX;
+    held_itow = UINT32_MAX;
+    dop_itow = UINT32_MAX;
+    dop_h = NAN;
+    dop_v = NAN;
+    utc_known = false;
+    utc_offset_ms = 0;
+    checksum_errors = 0;
+    overflows = 0;
+    reset();
+}
+
+void UBXStream::reset()
+{
+    state = State::SYNC_1;
+    received = 0;
+    ck_a = 0;
+    ck_b = 0;
+    received_ck_a = 0;
+}
+
+void UBXStream::checksum(const uint8_t byte)
+{
+    // 8-bit Fletcher over class, id, length and payload
+    ck_a += byte;
+    ck_b += ck_a;
+}
+
+bool UBXStream::feed(const uint8_t byte, GPSData* result)
+{
+    switch (state)
+    {
+    case State::SYNC_1:
+        if (byte == SYNC_1) state = State::SYNC_2;
+        return false;
+
+    case State::SYNC_2:
+        if (byte == SYNC_2) state = State::CLASS;
+        else if (byte != SYNC_1) reset();
+        return false;
+
+    case State::CLASS:
+        checksum(byte);
+        frame.cls = byte;
+        state = State::ID;
+        return false;
+
+    case State::ID:
+        checksum(byte);
+        frame.id = byte;
+        state = State::LENGTH_LO;
+        return false;
+
+    case State::LENGTH_LO:
+        checksum(byte);
+        frame.length = byte;
+        state = State::LENGTH_HI;
+        return false;
+
+    case State::LENGTH_HI:
+        checksum(byte);
+        frame.length |= byte << 8;
+        if (frame.length > MAX_PAYLOAD)
+        {
+            overflows++;
+            reset();
+            return false;
+        }
+        received = 0;
+        state = frame.length > 0 ? State::PAYLOAD : State::CHECKSUM_A;
+        return false;
+
+    case State::PAYLOAD:
+        checksum(byte);
+        frame.payload[received++] = byte;
+        if (received == frame.length) state = State::CHECKSUM_A;
+        return false;
+
+    case State::CHECKSUM_A:
+        received_ck_a = byte;
+        state = State::CHECKSUM_B;
+        return false;
+
+    case State::CHECKSUM_B:
+        {
+            const bool valid = received_ck_a == ck_a && byte == ck_b;
+            reset();
+            if (!valid)
+            {
+                checksum_errors++;
+                return false;
+            }
+            decode(result);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const UBXStream::Frame& UBXStream::getFrame() const
+{
+    return frame;
+}
+
+void UBXStream::decode(GPSData* result)
+{
+    *result = {};
+    result->timestamp = esp_timer_get_time();
+    result->checksum = true;
+
+    if (frame.cls != CLASS_NAV)
+    {
+        result->ignore = true;
+        return;
+    }
+
+    const uint8_t* p = frame.payload;
+    switch (frame.id)
+    {
+    case NAV_POSLLH:
+        if (frame.length != 28) break;
+        result->lon_e7 = i4(p + 4);
+        result->lat_e7 = i4(p + 8);
+        result->alt = static_cast<float>(i4(p + 16)) * 1e-3f; // hMSL, mm
+        result->content = IGPSModule::CONTENT_POS | IGPSModule::CONTENT_ALT;
+        if (holdUntilSolution(result)) return;
+        break;
+
+    case NAV_VELNED:
+        if (frame.length != 36) break;
+        result->spd = static_cast<float>(u4(p + 20)) * 1e-2f; // gSpeed, cm/s
+        result->hdg = static_cast<float>(i4(p + 24)) * 1e-5f; // heading, 1e-5 deg
+        result->content = IGPSModule::CONTENT_VEL;
+        if (holdUntilSolution(result)) return;
+        break;
+
+    case NAV_SOL:
+        {
+            if (frame.length != 52) break;
+            const uint8_t gps_fix = p[10];
+            const uint8_t flags = p[11];
+            // 0x02 - 2D, 0x03 - 3D, 0x04 - GPS + dead reckoning; bit 0 of flags - gpsFixOk
+            fix_ok = (flags & 0x01) != 0 && gps_fix >= 0x02 && gps_fix <= 0x04;
+            fix_itow = u4(p);
+            result->fix_type = fix_ok ? (gps_fix == 0x02 ? 2 : 3) : 1;
+            result->pdop = static_cast<float>(u2(p + 44)) * 1e-2f;
+            // Only NAV-DOP has the horizontal and vertical parts, unknown without one from this epoch
+            const bool dop = dop_itow == u4(p);
+            result->hdop = dop ? dop_h : NAN;
+            result->vdop = dop ? dop_v : NAN;
+            result->satellites = p[47];
+            result->content = IGPSModule::CONTENT_DOP;
+            result->valid = fix_ok;
+            if (held_itow == fix_itow)
+            {
+                // Position and velocity of this epoch were waiting for its fix status
+                const uint8_t content = held.content;
+                if (content & IGPSModule::CONTENT_POS)
+                {
+                    result->lat_e7 = held.lat_e7;
+                    result->lon_e7 = held.lon_e7;
+                    result->alt = held.alt;
+                }
+                if (content & IGPSModule::CONTENT_VEL)
+                {
+                    result->spd = held.spd;
+                    result->hdg = held.hdg;
+                }
+                result->content |= content;
+            }
+            held_itow = UINT32_MAX;
+            break;
+        }
+
+    case NAV_DOP:
+        // Kept for the NAV-SOL of the same epoch, which carries the fix type with it
+        result->ignore = true;
+        if (frame.length != 18) return;
+        dop_itow = u4(p);
+        dop_v = static_cast<float>(u2(p + 10)) * 1e-2f;
+        dop_h = static_cast<float>(u2(p + 12)) * 1e-2f;
+        return;
+
+    case NAV_TIMEUTC:
+        {
+            if (frame.length != 20) break;
+            const int32_t nano = i4(p + 8);
+            result->year = u2(p + 12);
+            result->month = p[14];
+            result->day = p[15];
+            // nano is a signed correction to the rounded second
+            result->time_ms = ((p[16] * 60 + p[17]) * 60 + p[18]) * 1000 + nano / 1000000;
+            if (result->time_ms < 0) result->time_ms += DAY_MS;
+            result->content = IGPSModule::CONTENT_TIME | IGPSModule::CONTENT_DATE;
+            result->valid = (p[19] & 0x04) != 0; // validUTC
+            if (result->valid)
+            {
+                utc_known = true;
+                utc_offset_ms = result->time_ms - static_cast<int32_t>(u4(p) % DAY_MS);
+            }
+            result->itow = u4(p);
+            return;
+        }
+
+    default:
+        result->ignore = true;
+        return;
+    }
+
+    if (result->content == 0)
+    {
+        // Known message with unexpected length
+        result->parse_error = true;
+        return;
+    }
+
+    // All NAV messages start with iTOW
+    result->itow = u4(p);
+    if (utc_known)
+    {
+        int32_t time_ms = static_cast<int32_t>(result->itow % DAY_MS) + utc_offset_ms;
+        if (time_ms < 0) time_ms += DAY_MS;
+        if (time_ms >= DAY_MS) time_ms -= DAY_MS;
+        result->time_ms = time_ms;
+        result->content |= IGPSModule::CONTENT_TIME;
+    }
+}
+
+bool UBXStream::holdUntilSolution(GPSData* result)
+{
+    const uint32_t itow = u4(frame.payload);
+    if (itow == fix_itow)
+    {
+        result->valid = fix_ok;
+        return false;
+    }
+
+    // NAV-SOL of this epoch is still to come, the previous one says nothing about it
+    if (held_itow != itow)
+    {
+        held = {};
+        held_itow = itow;
+    }
+    if (result->content & IGPSModule::CONTENT_POS)
+    {
+        held.lat_e7 = result->lat_e7;
+        held.lon_e7 = result->lon_e7;
+        held.alt = result->alt;
+    }
+    if (result->content & IGPSModule::CONTENT_VEL)
+    {
+        held.spd = result->spd;
+        held.hdg = result->hdg;
+    }
+    held.content |= result->content;
+
+    result->content = 0;
+    result->ignore = true;
+    return true;
+}
+
+bool UBXStream::idle() const
+{
+    return state == State::SYNC_1;
+}
+
+uint32_t UBXStream::getChecksumErrors() const
+{
+    return checksum_errors;
+}
+
+uint32_t UBXStream::getOverflows() const
+{
+    return overflows;
+}
+
+size_t UBXStream::encode(const uint8_t cls, const uint8_t id, const uint8_t* payload, const uint16_t length,
+                         uint8_t* out, const size_t size)
+{
+    if (size < length + FRAME_OVERHEAD) return 0;
+
+    out[0] = SYNC_1;
+    out[1] = SYNC_2;
+    out[2] = cls;
+    out[3] = id;
+    out[4] = length & 0xFF;
+    out[5] = length >> 8;
+    if (length > 0) memcpy(out + 6, payload, length);
+
+    uint8_t a = 0, b = 0;
+    for (size_t i = 2; i < 6 + static_cast<size_t>(length); i++)
+    {
+        a += out[i];
+        b += a;
+    }
+    out[6 + length] = a;
+    out[7 + length] = b;
+
+    return length + FRAME_OVERHEAD;
+}
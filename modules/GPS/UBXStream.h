@@ -0,0 +1,111 @@
+//
+// Created by stikper on 28.04.25.
+//
+
+#ifndef UBXSTREAM_H
+#define UBXSTREAM_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "IGPSModule.h"
+
+
+// Resumable byte-at-a-time u-blox UBX decoder: sync, class/id, length, payload, Fletcher checksum.
+// NAV frames are decoded into GPSData as soon as the last checksum byte arrives.
+class UBXStream
+{
+public:
+    using GPSData = IGPSModule::GPSData;
+
+    static constexpr uint8_t SYNC_1 = 0xB5;
+    static constexpr uint8_t SYNC_2 = 0x62;
+    static constexpr size_t MAX_PAYLOAD = 256;
+    static constexpr size_t FRAME_OVERHEAD = 8;
+
+    static constexpr uint8_t CLASS_NAV = 0x01;
+    static constexpr uint8_t CLASS_ACK = 0x05;
+    static constexpr uint8_t CLASS_CFG = 0x06;
+
+    static constexpr uint8_t NAV_POSLLH = 0x02;
+    static constexpr uint8_t NAV_DOP = 0x04;
+    static constexpr uint8_t NAV_SOL = 0x06;
+    static constexpr uint8_t NAV_VELNED = 0x12;
+    static constexpr uint8_t NAV_TIMEUTC = 0x21;
+    static constexpr uint8_t ACK_NAK = 0x00;
+    static constexpr uint8_t ACK_ACK = 0x01;
+    static constexpr uint8_t CFG_PRT = 0x00;
+    static constexpr uint8_t CFG_MSG = 0x01;
+    static constexpr uint8_t CFG_RATE = 0x08;
+
+    struct Frame
+    {
+        uint8_t cls = 0;
+        uint8_t id = 0;
+        uint16_t length = 0;
+        uint8_t payload[MAX_PAYLOAD] = {};
+    };
+
+private:
+    enum class State : uint8_t
+    {
+        SYNC_1,
+        SYNC_2,
+        CLASS,
+        ID,
+        LENGTH_LO,
+        LENGTH_HI,
+        PAYLOAD,
+        CHECKSUM_A,
+        CHECKSUM_B
+    };
+
+    State state;
+    Frame frame;
+    size_t received;
+    uint8_t ck_a;
+    uint8_t ck_b;
+    uint8_t received_ck_a;
+
+    // Fix status of the last NAV-SOL, POSLLH/VELNED carry no status of their own
+    bool fix_ok;
+    uint32_t fix_itow;
+    // POSLLH/VELNED that came before the NAV-SOL of their epoch, reported with it
+    GPSData held;
+    uint32_t held_itow;
+    // NAV-DOP of the epoch, comes before NAV-SOL and is reported with it
+    uint32_t dop_itow;
+    float dop_h;
+    float dop_v;
+    // UTC - GPS time of week from the last valid NAV-TIMEUTC, used to time-tag other NAV messages
+    bool utc_known;
+    int32_t utc_offset_ms;
+
+    uint32_t checksum_errors;
+    uint32_t overflows;
+
+    void checksum(uint8_t byte);
+    void decode(GPSData* result);
+    bool holdUntilSolution(GPSData* result);
+
+public:
+    UBXStream();
+
+    void reset();
+
+    // Returns true when a frame with a valid checksum has been received,
+    // frames other than supported NAV messages are marked ignore and left in getFrame()
+    bool feed(uint8_t byte, GPSData* result);
+    const Frame& getFrame() const;
+
+    bool idle() const;
+    uint32_t getChecksumErrors() const;
+    uint32_t getOverflows() const;
+
+    // Writes a complete frame into out, returns its size or 0 if it does not fit
+    static size_t encode(uint8_t cls, uint8_t id, const uint8_t* payload, uint16_t length, uint8_t* out,
+                         size_t size);
+};
+
+
+#endif //UBXSTREAM_H
@@ -0,0 +1,521 @@
+//
+// Created by stikper on 30.06.25.
+//
+
+#include "I2CBus.h"
+
+#include <numeric>
+
+#include <esp_log.h>
+#include <driver/i2c_master.h>
+
+
+I2CBus* I2CBus::buses[SOC_I2C_NUM] = {};
+
+I2CBus::I2CBus(const i2c_port_t port_num, const i2c_master_bus_handle_t handle)
+{
+    TAG = "I2C" + std::to_string(port_num);
+
+    port = port_num;
+    bus_handle = handle;
+
+    for (auto& device : devices)
+        device = {nullptr, 0};
+    device_count = 0;
+
+    for (auto& slot : slots)
+        slot = {};
+    order_count = 0;
+    frame_us = 0;
+    planned_load = 0;
+
+    request = {};
+    request_state.store(REQUEST_IDLE, std::memory_order_relaxed);
+
+    frame_timer = nullptr;
+    frame_origin = 0;
+    frame_ticks.store(0, std::memory_order_relaxed);
+    frames_handled = 0;
+    task_handle = nullptr;
+
+    started = esp_timer_get_time();
+    busy_us = 0;
+
+    planMutex = xSemaphoreCreateMutex();
+    requestMutex = xSemaphoreCreateMutex();
+    requestDone = xSemaphoreCreateBinary();
+}
+
+I2CBus::~I2CBus()
+{
+    if (frame_timer != nullptr)
+    {
+        esp_timer_stop(frame_timer);
+        esp_timer_delete(frame_timer);
+    }
+    if (task_handle != nullptr)
+        vTaskDelete(task_handle);
+
+    for (size_t i = 0; i < device_count; i++)
+        i2c_master_bus_rm_device(devices[i].handle);
+
+    if (planMutex != nullptr) vSemaphoreDelete(planMutex);
+    if (requestMutex != nullptr) vSemaphoreDelete(requestMutex);
+    if (requestDone != nullptr) vSemaphoreDelete(requestDone);
+
+    if (bus_handle != nullptr) i2c_del_master_bus(bus_handle);
+
+    if (buses[port] == this) buses[port] = nullptr;
+}
+
+bool I2CBus::owns(const i2c_port_t port_num)
+{
+    return port_num >= 0 && port_num < SOC_I2C_NUM && buses[port_num] != nullptr;
+}
+
+I2CBus* I2CBus::get(const i2c_port_t port_num, const gpio_num_t sda, const gpio_num_t scl)
+{
+    // Called while modules start, before any bus task runs
+    if (port_num < 0 || port_num >= SOC_I2C_NUM) return nullptr;
+    if (buses[port_num] != nullptr) return buses[port_num];
+
+    // A bus created elsewhere may have a transaction queue, which makes every transfer on it return before
+    // the data arrives. The timeline needs blocking transfers, so the port has to be its own
+    i2c_master_bus_handle_t handle = nullptr;
+    if (i2c_master_get_bus_handle(port_num, &handle) == ESP_OK)
+    {
+        ESP_LOGE("I2C", "I2C bus %d is already in use outside the scheduler", port_num);
+        return nullptr;
+    }
+
+    i2c_master_bus_config_t i2c_mst_config = {};
+    i2c_mst_config.clk_source = I2C_CLK_SRC_DEFAULT;
+    i2c_mst_config.i2c_port = port_num;
+    i2c_mst_config.sda_io_num = sda;
+    i2c_mst_config.scl_io_num = scl;
+    i2c_mst_config.glitch_ignore_cnt = 7;
+    i2c_mst_config.trans_queue_depth = 0; // Synchronous transfers
+    i2c_mst_config.flags.enable_internal_pullup = true;
+
+    esp_err_t ret = i2c_new_master_bus(&i2c_mst_config, &handle);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE("I2C", "Failed to initialize I2C bus %d", port_num);
+        return nullptr;
+    }
+
+    auto* bus = new I2CBus(port_num, handle);
+    if (bus->planMutex == nullptr || bus->requestMutex == nullptr || bus->requestDone == nullptr)
+    {
+        delete bus;
+        return nullptr;
+    }
+
+    esp_timer_create_args_t timer_args = {};
+    timer_args.callback = frameTimerCallback;
+    timer_args.arg = bus;
+    timer_args.name = "i2c_frame";
+    ret = esp_timer_create(&timer_args, &bus->frame_timer);
+    if (ret != ESP_OK)
+    {
+        delete bus;
+        return nullptr;
+    }
+
+    // Above the sensor tasks, the bus task only moves bytes and calls back
+    const BaseType_t created = xTaskCreate(busTaskWrapper, "i2c_bus", 4096, bus, 14, &bus->task_handle);
+    if (created != pdPASS)
+    {
+        bus->task_handle = nullptr;
+        delete bus;
+        return nullptr;
+    }
+
+    buses[port_num] = bus;
+    ESP_LOGI(bus->TAG.data(), "Bus scheduler started");
+    return bus;
+}
+
+esp_err_t I2CBus::addDevice(const uint16_t address, const uint32_t scl_speed_hz, int* device)
+{
+    if (device_count >= MAX_DEVICES) return ESP_ERR_NO_MEM;
+
+    i2c_device_config_t dev_cfg = {};
+    dev_cfg.dev_addr_length = I2C_ADDR_BIT_LEN_7;
+    dev_cfg.device_address = address;
+    dev_cfg.scl_speed_hz = scl_speed_hz;
+
+    i2c_master_dev_handle_t handle;
+    const esp_err_t ret = i2c_master_bus_add_device(bus_handle, &dev_cfg, &handle);
+    if (ret != ESP_OK) return ret;
+
+    devices[device_count] = {handle, scl_speed_hz};
+    *device = static_cast<int>(device_count);
+    device_count++;
+    return ESP_OK;
+}
+
+int64_t I2CBus::estimate(const int device, const size_t write_length, const size_t read_length) const
+{
+    // 9 clocks per byte with ACK, the address byte of each part, start, repeated start and stop
+    int64_t bits = 2;
+    if (write_length > 0) bits += 9 * (1 + static_cast<int64_t>(write_length));
+    if (read_length > 0) bits += 1 + 9 * (1 + static_cast<int64_t>(read_length));
+    return bits * 1000000 / devices[device].scl_speed_hz + TRANSFER_OVERHEAD_US;
+}
+
+bool I2CBus::plan(uint32_t* new_frame_us, float* new_load)
+{
+    // Priority order, ties by registration
+    size_t count = 0;
+    uint8_t sorted[MAX_PERIODIC];
+    for (size_t i = 0; i < MAX_PERIODIC; i++)
+    {
+        if (!slots[i].used) continue;
+        size_t pos = count++;
+        while (pos > 0 && slots[sorted[pos - 1]].config.priority < slots[i].config.priority)
+        {
+            sorted[pos] = sorted[pos - 1];
+            pos--;
+        }
+        sorted[pos] = static_cast<uint8_t>(i);
+    }
+
+    if (count == 0)
+    {
+        order_count = 0;
+        *new_frame_us = 0;
+        *new_load = 0;
+        return true;
+    }
+
+    uint32_t frame = UINT32_MAX;
+    for (size_t k = 0; k < count; k++)
+        if (slots[sorted[k]].config.period_us < frame) frame = slots[sorted[k]].config.period_us;
+
+    uint32_t periods[MAX_PERIODIC]; // In frames
+    uint32_t phases[MAX_PERIODIC];
+    int64_t bounds[MAX_PERIODIC];
+    int64_t worst = 0;
+    for (size_t k = 0; k < count; k++)
+    {
+        const Slot& slot = slots[sorted[k]];
+        if (slot.config.period_us % frame != 0) return false;
+        const uint32_t frames = slot.config.period_us / frame;
+        periods[k] = frames;
+
+        // Two reads share a frame when their phases agree modulo the gcd of their periods.
+        // Everything placed so far has at least this priority and runs before it
+        uint32_t best_phase = 0;
+        int64_t best_load = INT64_MAX;
+        for (uint32_t phase = 0; phase < frames && best_load > 0; phase++)
+        {
+            int64_t load = 0;
+            for (size_t j = 0; j < k; j++)
+            {
+                const uint32_t g = std::gcd(frames, periods[j]);
+                if ((phase + g - phases[j] % g) % g == 0) load += slots[sorted[j]].cost_us;
+            }
+            if (load < best_load)
+            {
+                best_load = load;
+                best_phase = phase;
+            }
+        }
+
+        const int64_t bound = best_load + slot.cost_us;
+        const uint32_t deadline = slot.config.deadline_us != 0 ? slot.config.deadline_us : frame;
+        if (bound > deadline) return false;
+
+        phases[k] = best_phase;
+        bounds[k] = bound;
+        if (bound > worst) worst = bound;
+    }
+
+    const float load = static_cast<float>(worst) / static_cast<float>(frame);
+    if (load > MAX_FRAME_LOAD) return false;
+
+    for (size_t k = 0; k < count; k++)
+    {
+        slots[sorted[k]].frames = periods[k];
+        slots[sorted[k]].phase = phases[k];
+        slots[sorted[k]].bound_us = bounds[k];
+        order[k] = sorted[k];
+    }
+    order_count = count;
+    *new_frame_us = frame;
+    *new_load = load;
+    return true;
+}
+
+esp_err_t I2CBus::restartTimer()
+{
+    esp_timer_stop(frame_timer);
+    frame_ticks.store(0, std::memory_order_relaxed);
+    frames_handled = 0;
+    if (order_count == 0) return ESP_OK;
+
+    frame_origin = esp_timer_get_time() + frame_us;
+    return esp_timer_start_periodic(frame_timer, frame_us);
+}
+
+esp_err_t I2CBus::addPeriodic(const periodic_t& transaction, int* id)
+{
+    if (transaction.device < 0 || static_cast<size_t>(transaction.device) >= device_count) return ESP_ERR_INVALID_ARG;
+    if (transaction.length == 0 || transaction.length > MAX_READ || transaction.period_us == 0)
+        return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(planMutex, portMAX_DELAY);
+
+    size_t index = 0;
+    while (index < MAX_PERIODIC && slots[index].used) index++;
+    if (index == MAX_PERIODIC)
+    {
+        xSemaphoreGive(planMutex);
+        return ESP_ERR_NO_MEM;
+    }
+
+    Slot& slot = slots[index];
+    slot = {};
+    slot.config = transaction;
+    slot.used = true;
+    slot.cost_us = estimate(transaction.device, 1, transaction.length);
+    if (transaction.follow_up > 0) slot.cost_us += estimate(transaction.device, 1, transaction.follow_up);
+
+    // Previous plan stays in force if the new read does not fit
+    const uint32_t previous_frame = frame_us;
+    uint32_t new_frame;
+    float new_load;
+    if (!plan(&new_frame, &new_load))
+    {
+        slot.used = false;
+        plan(&new_frame, &new_load);
+        xSemaphoreGive(planMutex);
+        ESP_LOGE(TAG.data(), "%s does not fit the bus timeline", transaction.name);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    frame_us = new_frame;
+    planned_load = new_load;
+
+    esp_err_t ret = ESP_OK;
+    if (order_count == 1 || frame_us != previous_frame) ret = restartTimer();
+    xSemaphoreGive(planMutex);
+
+    ESP_LOGI(TAG.data(), "%s: %lu us every %lu us, phase %lu, done within %lld us. Frame %lu us, load %.0f%%",
+             transaction.name, static_cast<unsigned long>(slot.cost_us),
+             static_cast<unsigned long>(transaction.period_us), static_cast<unsigned long>(slot.phase),
+             slot.bound_us, static_cast<unsigned long>(frame_us), planned_load * 100.0f);
+
+    *id = static_cast<int>(index);
+    return ret;
+}
+
+esp_err_t I2CBus::removePeriodic(const int id)
+{
+    if (id < 0 || static_cast<size_t>(id) >= MAX_PERIODIC) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(planMutex, portMAX_DELAY);
+    if (!slots[id].used)
+    {
+        xSemaphoreGive(planMutex);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    slots[id].used = false;
+    const uint32_t previous_frame = frame_us;
+    uint32_t new_frame;
+    float new_load;
+    plan(&new_frame, &new_load); // A subset of a feasible plan is feasible
+    frame_us = new_frame;
+    planned_load = new_load;
+
+    esp_err_t ret = ESP_OK;
+    if (order_count == 0 || frame_us != previous_frame) ret = restartTimer();
+    xSemaphoreGive(planMutex);
+    return ret;
+}
+
+esp_err_t I2CBus::execute(const int device, const uint8_t* write, const size_t write_length, uint8_t* read,
+                          const size_t read_length)
+{
+    const i2c_master_dev_handle_t handle = devices[device].handle;
+
+    const int64_t start = esp_timer_get_time();
+    esp_err_t ret;
+    if (read_length == 0)
+        ret = i2c_master_transmit(handle, write, write_length, TRANSFER_TIMEOUT_MS);
+    else if (write_length == 0)
+        ret = i2c_master_receive(handle, read, read_length, TRANSFER_TIMEOUT_MS);
+    else
+        ret = i2c_master_transmit_receive(handle, write, write_length, read, read_length, TRANSFER_TIMEOUT_MS);
+    busy_us += esp_timer_get_time() - start;
+
+    return ret;
+}
+
+void I2CBus::runFrame(const int64_t frame_start, const uint32_t frame_index)
+{
+    stats.frames++;
+
+    for (size_t k = 0; k < order_count; k++)
+    {
+        Slot& slot = slots[order[k]];
+        if (frame_index % slot.frames != slot.phase) continue;
+
+        const int64_t start = esp_timer_get_time();
+        const esp_err_t ret = execute(slot.config.device, &slot.config.reg, 1, read_buffer, slot.config.length);
+        slot.config.callback(slot.config.arg, ret, read_buffer, slot.config.length, start);
+        // Includes the follow-up transfer the callback ran
+        const int64_t completion = esp_timer_get_time() - frame_start;
+
+        slot.stats.runs++;
+        if (completion > static_cast<int64_t>(slot.stats.max_completion_us))
+            slot.stats.max_completion_us = static_cast<uint32_t>(completion);
+        const uint32_t deadline = slot.config.deadline_us != 0 ? slot.config.deadline_us : frame_us;
+        if (completion > deadline)
+        {
+            slot.stats.deadline_misses++;
+            stats.deadline_misses++;
+        }
+        if (ret != ESP_OK)
+        {
+            slot.stats.errors++;
+            stats.errors++;
+        }
+    }
+}
+
+void I2CBus::serveRequest(const int64_t next_frame)
+{
+    if (request_state.load(std::memory_order_acquire) != REQUEST_PENDING) return;
+
+    // Only into the slack before the next frame, so periodic reads keep their offsets
+    const int64_t cost = estimate(request.device, request.write_length, request.read_length);
+    if (next_frame > 0 && esp_timer_get_time() + cost > next_frame) return;
+
+    int expected = REQUEST_PENDING;
+    if (!request_state.compare_exchange_strong(expected, REQUEST_RUNNING, std::memory_order_acq_rel)) return;
+
+    request.result = execute(request.device, request.write, request.write_length, request.read, request.read_length);
+    request_state.store(REQUEST_DONE, std::memory_order_release);
+    xSemaphoreGive(requestDone);
+}
+
+esp_err_t I2CBus::transfer(const int device, const uint8_t* write, const size_t write_length, uint8_t* read,
+                           const size_t read_length, const TickType_t timeout)
+{
+    if (device < 0 || static_cast<size_t>(device) >= device_count) return ESP_ERR_INVALID_ARG;
+    if (write_length == 0 && read_length == 0) return ESP_ERR_INVALID_ARG;
+
+    // Callbacks already run in the bus task
+    if (xTaskGetCurrentTaskHandle() == task_handle)
+        return execute(device, write, write_length, read, read_length);
+
+    if (xSemaphoreTake(requestMutex, timeout) != pdTRUE) return ESP_ERR_TIMEOUT;
+
+    request = {device, write, write_length, read, read_length, ESP_FAIL};
+    request_state.store(REQUEST_PENDING, std::memory_order_release);
+    xTaskNotifyGive(task_handle);
+
+    if (xSemaphoreTake(requestDone, timeout) != pdTRUE)
+    {
+        // Withdrawn if it has not started, a running transfer ends within its own timeout
+        int expected = REQUEST_PENDING;
+        if (request_state.compare_exchange_strong(expected, REQUEST_IDLE, std::memory_order_acq_rel))
+        {
+            xSemaphoreGive(requestMutex);
+            return ESP_ERR_TIMEOUT;
+        }
+        xSemaphoreTake(requestDone, portMAX_DELAY);
+    }
+
+    const esp_err_t ret = request.result;
+    request_state.store(REQUEST_IDLE, std::memory_order_release);
+    xSemaphoreGive(requestMutex);
+    return ret;
+}
+
+void I2CBus::frameTimerCallback(void* arg)
+{
+    auto* bus = static_cast<I2CBus*>(arg);
+
+    bus->frame_ticks.fetch_add(1, std::memory_order_release);
+    xTaskNotifyGive(bus->task_handle);
+}
+
+void I2CBus::busTaskWrapper(void* param)
+{
+    auto* bus = static_cast<I2CBus*>(param);
+
+    bus->busTask();
+}
+
+_Noreturn void I2CBus::busTask()
+{
+    while (true)
+    {
+        // Frame tick or a one-off transfer. The plan lock is held while the bus is in use,
+        // so callbacks must not add or remove periodic reads
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        int64_t next_frame = 0; // No periodic reads, requests run right away
+        xSemaphoreTake(planMutex, portMAX_DELAY);
+        if (order_count > 0)
+        {
+            const uint32_t ticks = frame_ticks.load(std::memory_order_acquire);
+            if (ticks != frames_handled)
+            {
+                // Late wake-ups drop whole frames rather than squeezing two into one
+                if (ticks - frames_handled > 1) stats.skipped_frames += ticks - frames_handled - 1;
+                frames_handled = ticks;
+                runFrame(frame_origin + static_cast<int64_t>(ticks - 1) * frame_us, ticks - 1);
+            }
+            next_frame = frame_origin + static_cast<int64_t>(frames_handled) * frame_us;
+        }
+
+        serveRequest(next_frame);
+        xSemaphoreGive(planMutex);
+    }
+}
+
+I2CBus::Stats I2CBus::getStats() const
+{
+    Stats result = {};
+    if (xSemaphoreTake(planMutex, 100) == pdTRUE)
+    {
+        result = stats;
+        result.frame_us = frame_us;
+        result.planned_load = planned_load;
+        const int64_t elapsed = esp_timer_get_time() - started;
+        result.utilization = elapsed > 0 ? static_cast<float>(busy_us) / static_cast<float>(elapsed) : 0;
+        xSemaphoreGive(planMutex);
+    }
+    return result;
+}
+
+I2CBus::TransactionStats I2CBus::getTransactionStats(const int id) const
+{
+    TransactionStats result = {};
+    if (id < 0 || static_cast<size_t>(id) >= MAX_PERIODIC) return result;
+
+    if (xSemaphoreTake(planMutex, 100) == pdTRUE)
+    {
+        result = slots[id].stats;
+        xSemaphoreGive(planMutex);
+    }
+    return result;
+}
+
+void I2CBus::printStats() const
+{
+    const Stats bus = getStats();
+    ESP_LOGI(TAG.data(),
+             "\n🔌 I2C Bus Summary"
+             "\n├─ ⏱️ Frame:       %lu us, planned load %.0f%%"
+             "\n├─ 📊 Utilization: %.1f%%"
+             "\n└─ ⚠️ Frames %lu, skipped %lu, deadline misses %lu, errors %lu",
+             static_cast<unsigned long>(bus.frame_us), bus.planned_load * 100.0f,
+             bus.utilization * 100.0f,
+             static_cast<unsigned long>(bus.frames), static_cast<unsigned long>(bus.skipped_frames),
+             static_cast<unsigned long>(bus.deadline_misses), static_cast<unsigned long>(bus.errors));
+}
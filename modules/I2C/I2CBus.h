@@ -0,0 +1,186 @@
+//
+// Created by stikper on 30.06.25.
+//
+
+#ifndef I2CBUS_H
+#define I2CBUS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <driver/i2c_types.h>
+#include <esp_err.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <soc/gpio_num.h>
+#include <soc/soc_caps.h>
+
+
+// Sole owner of one I2C port, every transfer on it runs in the bus task.
+// Periodic register reads are laid out on a cyclic timeline: the shortest period is the frame, every other
+// period is a whole number of frames and gets the phase frame where the least work is already planned.
+// Inside a frame reads run back to back by priority, so the top priority read (the IMU) always starts at the
+// same offset from the frame start. Admission is checked against the worst frame with the estimated transfer times.
+// A callback may follow its read up with one dependent transfer (e.g. a FIFO drain sized by the count it read),
+// its worst case length is declared with the read. One-off transfers (configuration) run in the slack left at the
+// end of a frame.
+class I2CBus
+{
+public:
+    // status is ESP_OK with length bytes in data, time is the esp_timer start of the transfer
+    using callback_t = void (*)(void* arg, esp_err_t status, const uint8_t* data, size_t length, int64_t time);
+
+    struct periodic_t
+    {
+        const char* name;
+        int device;           // From addDevice
+        uint8_t reg;          // First register of the read
+        uint8_t length;       // Up to MAX_READ bytes
+        uint32_t period_us;   // Whole number of frames
+        uint32_t deadline_us; // Completion after the frame start, 0 for the end of the frame
+        uint8_t priority;     // Higher runs first in a frame
+        uint8_t follow_up;    // Bytes the callback may read with transfer() right after, planned as part of the slot
+        callback_t callback;  // Called from the bus task
+        void* arg;
+    };
+
+    struct Stats
+    {
+        uint32_t frame_us = 0;
+        float planned_load = 0;   // Worst frame estimate / frame length
+        float utilization = 0;    // Measured bus time / elapsed time since start
+        uint32_t frames = 0;
+        uint32_t skipped_frames = 0; // Frames the bus task woke up too late for
+        uint32_t deadline_misses = 0;
+        uint32_t errors = 0;
+    };
+
+    struct TransactionStats
+    {
+        uint32_t runs = 0;
+        uint32_t deadline_misses = 0;
+        uint32_t errors = 0;
+        uint32_t max_completion_us = 0; // After the frame start
+    };
+
+    static constexpr size_t MAX_DEVICES = 8;
+    static constexpr size_t MAX_PERIODIC = 8;
+    static constexpr size_t MAX_READ = 32;
+
+private:
+    static constexpr float MAX_FRAME_LOAD = 0.8f;    // Rest of the frame is kept for one-off transfers
+    static constexpr int64_t TRANSFER_OVERHEAD_US = 20; // Driver setup and interrupt latency per transfer
+    static constexpr int TRANSFER_TIMEOUT_MS = 10;
+
+    struct Device
+    {
+        i2c_master_dev_handle_t handle;
+        uint32_t scl_speed_hz;
+    };
+
+    struct Slot
+    {
+        periodic_t config;
+        bool used;
+        int64_t cost_us;  // Estimated transfer time
+        uint32_t frames;  // Period in frames
+        uint32_t phase;   // Frame index modulo frames it runs in
+        int64_t bound_us; // Worst completion after the frame start
+        TransactionStats stats;
+    };
+
+    // One-off transfer handed to the bus task. Caller buffers stay valid until it leaves PENDING or RUNNING
+    enum request_state_t : int
+    {
+        REQUEST_IDLE,
+        REQUEST_PENDING,
+        REQUEST_RUNNING,
+        REQUEST_DONE
+    };
+
+    struct Request
+    {
+        int device;
+        const uint8_t* write;
+        size_t write_length;
+        uint8_t* read;
+        size_t read_length;
+        esp_err_t result;
+    };
+
+    static I2CBus* buses[SOC_I2C_NUM];
+
+    std::string TAG;
+
+    i2c_port_t port;
+    i2c_master_bus_handle_t bus_handle;
+
+    Device devices[MAX_DEVICES];
+    size_t device_count;
+
+    SemaphoreHandle_t planMutex; // Guards slots, the plan and the frame timer against addPeriodic/removePeriodic
+    Slot slots[MAX_PERIODIC];
+    uint8_t order[MAX_PERIODIC]; // Used slots by descending priority
+    size_t order_count;
+    uint32_t frame_us;
+    float planned_load;
+
+    SemaphoreHandle_t requestMutex; // One one-off transfer at a time
+    SemaphoreHandle_t requestDone;
+    Request request;
+    std::atomic<int> request_state;
+
+    // Frame n starts at frame_origin + n * frame_us, the timer counts the frames that have started
+    esp_timer_handle_t frame_timer;
+    int64_t frame_origin;
+    std::atomic<uint32_t> frame_ticks;
+    uint32_t frames_handled;
+    TaskHandle_t task_handle;
+
+    uint8_t read_buffer[MAX_READ];
+    int64_t started;
+    int64_t busy_us;
+    Stats stats;
+
+    I2CBus(i2c_port_t port_num, i2c_master_bus_handle_t handle);
+
+    int64_t estimate(int device, size_t write_length, size_t read_length) const;
+    bool plan(uint32_t* new_frame_us, float* new_load);
+    esp_err_t restartTimer();
+
+    esp_err_t execute(int device, const uint8_t* write, size_t write_length, uint8_t* read, size_t read_length);
+    void runFrame(int64_t frame_start, uint32_t frame_index);
+    void serveRequest(int64_t next_frame);
+
+    static void frameTimerCallback(void* arg);
+    static void busTaskWrapper(void* param);
+    _Noreturn void busTask();
+
+public:
+    ~I2CBus();
+
+    // Bus of the port, created and started on first use. nullptr if the port already has a master bus from outside
+    static I2CBus* get(i2c_port_t port_num, gpio_num_t sda, gpio_num_t scl);
+    // The port is scheduled, modules must not create their own bus on it
+    static bool owns(i2c_port_t port_num);
+
+    esp_err_t addDevice(uint16_t address, uint32_t scl_speed_hz, int* device);
+
+    // ESP_ERR_INVALID_SIZE if the timeline cannot fit it with every deadline met
+    esp_err_t addPeriodic(const periodic_t& transaction, int* id);
+    esp_err_t removePeriodic(int id);
+
+    // Blocking one-off transfer, write then read with a repeated start. Either part may be empty
+    esp_err_t transfer(int device, const uint8_t* write, size_t write_length, uint8_t* read, size_t read_length,
+                       TickType_t timeout);
+
+    Stats getStats() const;
+    TransactionStats getTransactionStats(int id) const;
+    void printStats() const;
+};
+
+
+#endif //I2CBUS_H
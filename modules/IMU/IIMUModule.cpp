@@ -5,104 +5,69 @@
 #include "IIMUModule.h"
 
 #include <esp_log.h>
-#include <stdexcept>
 
 IIMUModule::IIMUModule()
 {
     TAG = "IMU";
-
-    lastAngVel.dataMutex = xSemaphoreCreateMutex();
-    lastAccel.dataMutex = xSemaphoreCreateMutex();
-    lastTemp.dataMutex = xSemaphoreCreateMutex();
-
-
-    // TODO: Test throw error
-    if (lastAngVel.dataMutex == nullptr || lastAccel.dataMutex == nullptr || lastTemp.dataMutex == nullptr)
-        throw std::runtime_error("Failed to create IMU data mutex");
 }
 
-IIMUModule::~IIMUModule()
-{
-    if (lastAngVel.dataMutex != nullptr)
-        vSemaphoreDelete(lastAngVel.dataMutex);
-    if (lastAccel.dataMutex != nullptr)
-        vSemaphoreDelete(lastAccel.dataMutex);
-    if (lastTemp.dataMutex != nullptr)
-        vSemaphoreDelete(lastTemp.dataMutex);
-}
+IIMUModule::~IIMUModule() = default;
 
 void IIMUModule::updateData(int64_t timestamp, const float* accel, const float* gyro, const float* temp)
 {
-    if (xSemaphoreTake(lastAccel.dataMutex, 100) == pdTRUE)
+    Sample sample;
+    sample.timestamp = timestamp;
+    for (int i = 0; i < 3; i++)
     {
-        lastAccel.ax = accel[0];
-        lastAccel.ay = accel[1];
-        lastAccel.az = accel[2];
-        lastAccel.timestamp = timestamp;
-        xSemaphoreGive(lastAccel.dataMutex);
+        sample.accel[i] = accel[i];
+        sample.gyro[i] = gyro[i];
     }
+    sample.temp = temp[0];
 
-    if (xSemaphoreTake(lastTemp.dataMutex, 100) == pdTRUE)
-    {
-        lastTemp.t = temp[0];
-        lastTemp.timestamp = timestamp;
-        xSemaphoreGive(lastTemp.dataMutex);
-    }
+    lastSample.store(sample);
+    samples.push(sample);
+}
 
-    if (xSemaphoreTake(lastAngVel.dataMutex, 100) == pdTRUE)
-    {
-        lastAngVel.wx = gyro[0];
-        lastAngVel.wy = gyro[1];
-        lastAngVel.wz = gyro[2];
-        lastAngVel.timestamp = timestamp;
-        xSemaphoreGive(lastAngVel.dataMutex);
-    }
+IIMUModule::Sample IIMUModule::getSample() const
+{
+    return lastSample.load();
 }
 
 IIMUModule::AngVel IIMUModule::getAngVel() const
 {
-    AngVel result = {};
-    if (xSemaphoreTake(lastAngVel.dataMutex, 100) == pdTRUE)
-    {
-        result = lastAngVel;
-        xSemaphoreGive(lastAngVel.dataMutex);
-        result.dataMutex = nullptr;
-        return result;
-    }
-    return result;
+    const Sample sample = lastSample.load();
+    return {sample.timestamp, sample.gyro[0], sample.gyro[1], sample.gyro[2]};
 }
 
 IIMUModule::Accel IIMUModule::getAccel() const
 {
-    Accel result = {};
-    if (xSemaphoreTake(lastAccel.dataMutex, 100) == pdTRUE)
-    {
-        result = lastAccel;
-        xSemaphoreGive(lastAccel.dataMutex);
-        result.dataMutex = nullptr;
-        return result;
-    }
-    return result;
+    const Sample sample = lastSample.load();
+    return {sample.timestamp, sample.accel[0], sample.accel[1], sample.accel[2]};
 }
 
 IIMUModule::Temperature IIMUModule::getTemp() const
 {
-    Temperature result = {};
-    if (xSemaphoreTake(lastTemp.dataMutex, 100) == pdTRUE)
-    {
-        result = lastTemp;
-        xSemaphoreGive(lastTemp.dataMutex);
-        result.dataMutex = nullptr;
-        return result;
-    }
-    return result;
+    const Sample sample = lastSample.load();
+    return {sample.timestamp, sample.temp};
+}
+
+IIMUModule::SampleCursor IIMUModule::getCursor() const
+{
+    return samples.cursor();
+}
+
+size_t IIMUModule::readSince(SampleCursor& cursor, const std::span<Sample> out) const
+{
+    return samples.readSince(cursor, out);
 }
 
 void IIMUModule::printLastData() const
 {
-    AngVel angVel = getAngVel();
-    Accel accel = getAccel();
-    Temperature temp = getTemp();
+    // One snapshot, all three parts come from the same sample
+    const Sample sample = getSample();
+    const AngVel angVel = {sample.timestamp, sample.gyro[0], sample.gyro[1], sample.gyro[2]};
+    const Accel accel = {sample.timestamp, sample.accel[0], sample.accel[1], sample.accel[2]};
+    const Temperature temp = {sample.timestamp, sample.temp};
     // Convert timestamps to readable format (assuming timestamps are in microseconds)
     int64_t angVelTime = angVel.timestamp / 1000; // Convert to milliseconds
     int64_t accelTime = accel.timestamp / 1000;
@@ -7,9 +7,11 @@
 
 #include <cstdint>
 #include <esp_err.h>
+#include <span>
 #include <string>
-#include <freertos/FreeRTOS.h>
-#include <freertos/semphr.h>
+
+#include "Common/Snapshot.h"
+#include "SampleRing.h"
 
 
 class IIMUModule
@@ -17,7 +19,6 @@ class IIMUModule
 public:
     struct AngVel
     {
-        SemaphoreHandle_t dataMutex = nullptr;
         int64_t timestamp = -1;
         float wx = 0;
         float wy = 0;
@@ -25,7 +26,6 @@ public:
     };
     struct Accel
     {
-        SemaphoreHandle_t dataMutex = nullptr;
         int64_t timestamp = -1;
         float ax = 0;
         float ay = 0;
@@ -33,17 +33,27 @@ public:
     };
     struct Temperature
     {
-        SemaphoreHandle_t dataMutex = nullptr;
         int64_t timestamp = -1;
         float t = 0;
     };
+    // One complete measurement, all fields from the same sensor sample
+    struct Sample
+    {
+        int64_t timestamp = -1;
+        float accel[3] = {};
+        float gyro[3] = {};
+        float temp = 0;
+    };
+
+    static constexpr size_t SAMPLE_RING_SIZE = 256; // 256 ms at 1 kHz
+    using SampleCursor = SampleRing<Sample, SAMPLE_RING_SIZE>::Cursor;
 
 private:
     std::string TAG;
 
-    AngVel lastAngVel;
-    Accel lastAccel;
-    Temperature lastTemp;
+    Snapshot<Sample> lastSample;
+
+    SampleRing<Sample, SAMPLE_RING_SIZE> samples;
 
 protected:
     IIMUModule();
@@ -53,10 +63,16 @@ protected:
 public:
     virtual ~IIMUModule();
 
+    // Accel, gyro and temperature of the newest sample, consistent with each other
+    Sample getSample() const;
     AngVel getAngVel() const;
     Accel getAccel() const;
     Temperature getTemp() const;
 
+    // Every sample since the cursor, without locks. Start from getCursor() to skip the backlog
+    SampleCursor getCursor() const;
+    size_t readSince(SampleCursor& cursor, std::span<Sample> out) const;
+
     void printLastData() const;
 
     virtual esp_err_t start() = 0;
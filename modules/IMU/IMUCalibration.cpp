@@ -0,0 +1,261 @@
+//
+// Created by stikper on 23.06.25.
+//
+
+#include "IMUCalibration.h"
+
+#include <cmath>
+
+#include <esp_log.h>
+#include <nvs.h>
+
+
+IMUCalibration::IMUCalibration(const char* nvs_key)
+{
+    TAG = "IMU_CAL";
+    key = nvs_key;
+
+    stored = false;
+    state = CAL_IDLE;
+    validate_samples = 0;
+    full_samples = 0;
+    applied_temp = NAN;
+    saving.store(false, std::memory_order_relaxed);
+    resetWindow();
+}
+
+esp_err_t IMUCalibration::load()
+{
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (ret != ESP_OK) return ret == ESP_ERR_NVS_NOT_FOUND ? ESP_ERR_NOT_FOUND : ret;
+
+    Coefficients loaded;
+    size_t length = sizeof(loaded);
+    ret = nvs_get_blob(handle, key.data(), &loaded, &length);
+    nvs_close(handle);
+    if (ret == ESP_ERR_NVS_NOT_FOUND) return ESP_ERR_NOT_FOUND;
+    if (ret != ESP_OK) return ret;
+
+    // Layout changes bump the version, anything else is a corrupted entry
+    if (length != sizeof(loaded) || loaded.version != VERSION) return ESP_ERR_NOT_FOUND;
+    const float* values = &loaded.reference_temp;
+    for (size_t i = 0; i < (sizeof(loaded) - sizeof(loaded.version)) / sizeof(float); i++)
+        if (!std::isfinite(values[i])) return ESP_ERR_NOT_FOUND;
+
+    coeffs = loaded;
+    stored = true;
+    applied_temp = NAN;
+    return ESP_OK;
+}
+
+esp_err_t IMUCalibration::store(const Coefficients& value) const
+{
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) return ret;
+
+    ret = nvs_set_blob(handle, key.data(), &value, sizeof(value));
+    if (ret == ESP_OK) ret = nvs_commit(handle);
+    nvs_close(handle);
+    return ret;
+}
+
+esp_err_t IMUCalibration::save()
+{
+    coeffs.version = VERSION;
+    const esp_err_t ret = store(coeffs);
+    if (ret == ESP_OK) stored = true;
+    return ret;
+}
+
+void IMUCalibration::saveLater()
+{
+    if (saving.load(std::memory_order_acquire))
+    {
+        ESP_LOGW(TAG.data(), "Previous calibration is still being stored, skipping");
+        return;
+    }
+
+    unsaved = coeffs;
+    unsaved.version = VERSION;
+    saving.store(true, std::memory_order_release);
+    if (xTaskCreate(saveTask, "imu_cal_save", SAVE_TASK_STACK_SIZE, this, SAVE_TASK_PRIORITY, nullptr) != pdPASS)
+    {
+        saving.store(false, std::memory_order_release);
+        ESP_LOGW(TAG.data(), "Failed to create calibration save task");
+        return;
+    }
+
+    // Reference point is set from here on, whether or not the write succeeds
+    stored = true;
+}
+
+void IMUCalibration::saveTask(void* param)
+{
+    auto* calibration = static_cast<IMUCalibration*>(param);
+
+    const esp_err_t ret = calibration->store(calibration->unsaved);
+    if (ret != ESP_OK) ESP_LOGW(calibration->TAG.data(), "Failed to store calibration: %d", ret);
+    else ESP_LOGI(calibration->TAG.data(), "Calibration stored");
+
+    calibration->saving.store(false, std::memory_order_release);
+    vTaskDelete(nullptr);
+}
+
+void IMUCalibration::begin(const size_t validate_window, const size_t full_window)
+{
+    validate_samples = validate_window > 0 ? validate_window : 1;
+    full_samples = full_window > validate_samples ? full_window : validate_samples;
+    state = stored ? CAL_VALIDATING : CAL_CALIBRATING;
+    resetWindow();
+
+    ESP_LOGI(TAG.data(), stored ? "Validating stored calibration over %u samples" : "Calibrating over %u samples",
+             static_cast<unsigned>(stored ? validate_samples : full_samples));
+}
+
+void IMUCalibration::resetWindow()
+{
+    window = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        gyro_sum[i] = 0;
+        gyro_sq[i] = 0;
+    }
+    accel_sum = 0;
+    accel_sq = 0;
+    temp_sum = 0;
+}
+
+void IMUCalibration::feed(const float* si)
+{
+    if (state != CAL_VALIDATING && state != CAL_CALIBRATING) return;
+
+    for (int i = 0; i < 3; i++)
+    {
+        const float w = si[IMUConverter::GYRO + i];
+        gyro_sum[i] += w;
+        gyro_sq[i] += w * w;
+    }
+    const float* a = si + IMUConverter::ACCEL;
+    const float norm = sqrtf(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+    accel_sum += norm;
+    accel_sq += norm * norm;
+    temp_sum += si[IMUConverter::TEMP];
+    window++;
+
+    if (window >= (state == CAL_VALIDATING ? validate_samples : full_samples)) finishWindow();
+}
+
+void IMUCalibration::finishWindow()
+{
+    const auto n = static_cast<float>(window);
+
+    float residual[3];
+    bool stationary = true;
+    bool holds = true;
+    for (int i = 0; i < 3; i++)
+    {
+        residual[i] = gyro_sum[i] / n;
+        const float variance = gyro_sq[i] / n - residual[i] * residual[i];
+        if (variance > STATIONARY_GYRO_STD * STATIONARY_GYRO_STD) stationary = false;
+        if (fabsf(residual[i]) > VALID_GYRO_RESIDUAL) holds = false;
+    }
+    const float accel_mean = accel_sum / n;
+    if (accel_sq / n - accel_mean * accel_mean > STATIONARY_ACCEL_STD * STATIONARY_ACCEL_STD) stationary = false;
+    const float temp = temp_sum / n;
+
+    if (!stationary)
+    {
+        // Stored coefficients stay in use until the sensor rests for a whole window
+        ESP_LOGW(TAG.data(), "Sensor moved during the calibration window, retrying");
+        resetWindow();
+        return;
+    }
+
+    if (state == CAL_VALIDATING)
+    {
+        if (holds)
+        {
+            ESP_LOGI(TAG.data(), "Stored calibration confirmed at %.1f °C", temp);
+            state = CAL_READY;
+            return;
+        }
+
+        ESP_LOGW(TAG.data(), "Stored gyro bias is off by %.2f %.2f %.2f °/s, recalibrating",
+                 residual[0], residual[1], residual[2]);
+        state = CAL_CALIBRATING;
+        resetWindow();
+        return;
+    }
+
+    updateBias(residual, temp);
+    saveLater();
+
+    ESP_LOGI(TAG.data(), "Gyro bias %.3f %.3f %.3f °/s at %.1f °C",
+             coeffs.gyro_bias[0], coeffs.gyro_bias[1], coeffs.gyro_bias[2], coeffs.reference_temp);
+    applied_temp = NAN;
+    state = CAL_READY;
+}
+
+void IMUCalibration::updateBias(const float* residual, const float temp)
+{
+    // Samples were corrected by the bias at the window temperature, what is left on top of it is the error
+    const float delta_t = temp - coeffs.reference_temp;
+    for (int i = 0; i < 3; i++)
+    {
+        const float measured = coeffs.gyro_bias[i] + coeffs.gyro_slope[i] * delta_t + residual[i];
+        if (stored && fabsf(delta_t) >= SLOPE_MIN_DELTA_T)
+            coeffs.gyro_slope[i] = (measured - coeffs.gyro_bias[i]) / delta_t;
+        else
+            coeffs.gyro_bias[i] = measured - coeffs.gyro_slope[i] * delta_t;
+    }
+
+    // First calibration defines the reference point
+    if (!stored) coeffs.reference_temp = temp;
+}
+
+void IMUCalibration::apply(IMUConverter& converter, const float temp)
+{
+    if (fabsf(temp - applied_temp) < APPLY_STEP_T) return; // Also false for NaN
+    applied_temp = temp;
+
+    const float delta_t = temp - coeffs.reference_temp;
+
+    float gain[IMUConverter::CHANNELS];
+    float bias[IMUConverter::CHANNELS];
+    for (size_t channel = 0; channel < IMUConverter::CHANNELS; channel++)
+    {
+        gain[channel] = 1.0f;
+        bias[channel] = 0.0f;
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        gain[IMUConverter::ACCEL + i] = coeffs.accel_scale[i];
+        bias[IMUConverter::ACCEL + i] = coeffs.accel_offset[i] + coeffs.accel_slope[i] * delta_t;
+        bias[IMUConverter::GYRO + i] = coeffs.gyro_bias[i] + coeffs.gyro_slope[i] * delta_t;
+    }
+    converter.setCorrection(gain, bias);
+}
+
+IMUCalibration::state_t IMUCalibration::getState() const
+{
+    return state;
+}
+
+bool IMUCalibration::isReady() const
+{
+    return state == CAL_READY;
+}
+
+const IMUCalibration::Coefficients& IMUCalibration::getCoefficients() const
+{
+    return coeffs;
+}
+
+esp_err_t IMUCalibration::setCoefficients(const Coefficients& coefficients)
+{
+    Coefficients value = coefficients;
+    value.version = VERSION;
+    return store(value);
+}
@@ -0,0 +1,120 @@
+//
+// Created by stikper on 23.06.25.
+//
+
+#ifndef IMUCALIBRATION_H
+#define IMUCALIBRATION_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "IMUConverter.h"
+
+
+// Sensor corrections kept in NVS between boots.
+// Biases are linear in the die temperature around the one they were measured at, so a warm boot only has to
+// confirm the stored gyro bias over a short stationary window instead of averaging a new one from scratch.
+// Corrections go into the converter factors and are refreshed when the temperature moves, not per sample.
+class IMUCalibration
+{
+public:
+    struct Coefficients
+    {
+        uint32_t version = 0;
+        float reference_temp = 25.0f; // °C the biases below were taken at
+        float gyro_bias[3] = {};      // °/s
+        float gyro_slope[3] = {};     // °/s per °C
+        float accel_offset[3] = {};   // m/s²
+        float accel_slope[3] = {};    // m/s² per °C
+        float accel_scale[3] = {1.0f, 1.0f, 1.0f};
+    };
+
+    enum state_t
+    {
+        CAL_IDLE,
+        CAL_VALIDATING,  // Stored coefficients in use, checking the gyro bias still holds
+        CAL_CALIBRATING, // Averaging a new gyro bias
+        CAL_READY
+    };
+
+private:
+    static constexpr uint32_t VERSION = 1;
+    static constexpr const char* NVS_NAMESPACE = "imu_cal";
+
+    // New coefficients are written by a short lived task, a flash erase would stall the sampling path
+    static constexpr uint32_t SAVE_TASK_STACK_SIZE = 3072;
+    static constexpr int SAVE_TASK_PRIORITY = 1; // Just above idle
+
+    // Window counts as stationary below these standard deviations
+    static constexpr float STATIONARY_GYRO_STD = 0.5f;  // °/s
+    static constexpr float STATIONARY_ACCEL_STD = 0.2f; // m/s², of the acceleration magnitude
+    // Largest mean corrected rate at rest that keeps the stored bias
+    static constexpr float VALID_GYRO_RESIDUAL = 0.2f;  // °/s
+    // Smallest temperature difference a new bias is turned into a slope from
+    static constexpr float SLOPE_MIN_DELTA_T = 5.0f;    // °C
+    // Temperature change that refreshes the converter factors
+    static constexpr float APPLY_STEP_T = 0.25f;        // °C
+
+    std::string TAG;
+    std::string key;
+
+    Coefficients coeffs;
+    bool stored;
+
+    state_t state;
+    size_t validate_samples;
+    size_t full_samples;
+
+    // Stationary window over corrected samples
+    size_t window;
+    float gyro_sum[3];
+    float gyro_sq[3];
+    float accel_sum;
+    float accel_sq;
+    float temp_sum;
+
+    float applied_temp; // NaN until the factors were applied
+
+    // Copy of the coefficients owned by the save task while saving is set
+    Coefficients unsaved;
+    std::atomic<bool> saving;
+
+    esp_err_t store(const Coefficients& value) const;
+    void saveLater();
+    static void saveTask(void* param);
+    void resetWindow();
+    void finishWindow();
+    void updateBias(const float* residual, float temp);
+
+public:
+    explicit IMUCalibration(const char* nvs_key);
+
+    // Reads the coefficients, ESP_ERR_NOT_FOUND if nothing valid is stored
+    esp_err_t load();
+    // Writes the coefficients right away, blocks for the flash erase and write
+    esp_err_t save();
+
+    // Starts a validation window if coefficients were loaded, a full calibration otherwise
+    void begin(size_t validate_window, size_t full_window);
+
+    // One converted, already corrected sample (IMUConverter record layout)
+    void feed(const float* si);
+
+    // Converter factors for the temperature, only if it moved enough since the last call
+    void apply(IMUConverter& converter, float temp);
+
+    state_t getState() const;
+    bool isReady() const;
+    const Coefficients& getCoefficients() const;
+    // Replaces the coefficients, e.g. with accel offsets and scales from a multi-position procedure,
+    // and stores them. Takes effect at the next start
+    esp_err_t setCoefficients(const Coefficients& coefficients);
+};
+
+
+#endif //IMUCALIBRATION_H
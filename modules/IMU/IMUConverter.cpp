@@ -0,0 +1,161 @@
+//
+// Created by stikper on 16.06.25.
+//
+
+#include "IMUConverter.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define IMU_CONVERT_SSE2
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define IMU_CONVERT_NEON
+#endif
+
+
+IMUConverter::IMUConverter()
+{
+    setCorrection(nullptr, nullptr);
+    setScales(0, 0);
+}
+
+void IMUConverter::setScales(const uint8_t accel_scale, const uint8_t gyro_scale)
+{
+    // Full scale doubles with every step: ±2g / ±250°/s at 0
+    const float accel = 9.81f * static_cast<float>(1 << (accel_scale & 0x03)) / 16384.0f;
+    const float gyro = static_cast<float>(1 << (gyro_scale & 0x03)) / 131.0f;
+
+    for (size_t channel = 0; channel < CHANNELS; channel++)
+    {
+        if (channel == TEMP)
+        {
+            sensor_scale[channel] = 1.0f / 340.0f;
+            sensor_offset[channel] = 36.53f;
+        }
+        else
+        {
+            sensor_scale[channel] = channel < TEMP ? accel : gyro;
+            sensor_offset[channel] = 0.0f;
+        }
+    }
+    rebuild();
+}
+
+void IMUConverter::setCorrection(const float* channel_gain, const float* channel_bias)
+{
+    for (size_t channel = 0; channel < CHANNELS; channel++)
+    {
+        gain[channel] = channel_gain != nullptr ? channel_gain[channel] : 1.0f;
+        bias[channel] = channel_bias != nullptr ? channel_bias[channel] : 0.0f;
+    }
+    rebuild();
+}
+
+void IMUConverter::rebuild()
+{
+    for (size_t i = 0; i < BLOCK_VALUES; i++)
+    {
+        const size_t channel = i % CHANNELS;
+        scale[i] = sensor_scale[channel] * gain[channel];
+        offset[i] = (sensor_offset[channel] - bias[channel]) * gain[channel];
+    }
+}
+
+void IMUConverter::convertScalar(const uint8_t* records, const size_t count, float* out) const
+{
+    for (size_t r = 0; r < count; r++)
+    {
+        const uint8_t* in = records + r * RECORD_SIZE;
+        float* dst = out + r * CHANNELS;
+        for (size_t channel = 0; channel < CHANNELS; channel++)
+        {
+            const auto raw = static_cast<int16_t>(in[2 * channel] << 8 | in[2 * channel + 1]);
+            dst[channel] = static_cast<float>(raw) * scale[channel] + offset[channel];
+        }
+    }
+}
+
+void IMUConverter::convert(const uint8_t* records, const size_t count, float* out) const
+{
+    const size_t blocks = count / BLOCK_RECORDS;
+    convertBlocks(records, blocks, out);
+
+    const size_t done = blocks * BLOCK_RECORDS;
+    convertScalar(records + done * RECORD_SIZE, count - done, out + done * CHANNELS);
+}
+
+#if defined(IMU_CONVERT_SSE2)
+
+void IMUConverter::convertBlocks(const uint8_t* records, const size_t blocks, float* out) const
+{
+    for (size_t b = 0; b < blocks; b++)
+    {
+        const uint8_t* in = records + b * BLOCK_RECORDS * RECORD_SIZE;
+        float* dst = out + b * BLOCK_VALUES;
+
+        // 56 bytes: three full loads and a half one
+        __m128i words[4];
+        for (int i = 0; i < 3; i++)
+            words[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 16 * i));
+        words[3] = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + 48));
+
+        for (int i = 0; i < 4; i++)
+        {
+            // Big-endian to native, then sign extend each half to int32
+            const __m128i swapped = _mm_or_si128(_mm_slli_epi16(words[i], 8), _mm_srli_epi16(words[i], 8));
+            const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(swapped, swapped), 16);
+            const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(swapped, swapped), 16);
+
+            const size_t v = 8 * i;
+            _mm_storeu_ps(dst + v, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(lo), _mm_load_ps(scale + v)),
+                                              _mm_load_ps(offset + v)));
+            if (i == 3) break;
+            _mm_storeu_ps(dst + v + 4, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(hi), _mm_load_ps(scale + v + 4)),
+                                                  _mm_load_ps(offset + v + 4)));
+        }
+    }
+}
+
+const char* IMUConverter::simdPath()
+{
+    return "sse2";
+}
+
+#elif defined(IMU_CONVERT_NEON)
+
+void IMUConverter::convertBlocks(const uint8_t* records, const size_t blocks, float* out) const
+{
+    for (size_t b = 0; b < blocks; b++)
+    {
+        const uint8_t* in = records + b * BLOCK_RECORDS * RECORD_SIZE;
+        float* dst = out + b * BLOCK_VALUES;
+
+        // 56 bytes: seven 8-byte loads of four values each
+        for (size_t v = 0; v < BLOCK_VALUES; v += 4)
+        {
+            const int16x4_t raw = vreinterpret_s16_u8(vrev16_u8(vld1_u8(in + 2 * v)));
+            const float32x4_t value = vcvtq_f32_s32(vmovl_s16(raw));
+            vst1q_f32(dst + v, vaddq_f32(vmulq_f32(value, vld1q_f32(scale + v)), vld1q_f32(offset + v)));
+        }
+    }
+}
+
+const char* IMUConverter::simdPath()
+{
+    return "neon";
+}
+
+#else
+
+// No vector unit the compiler can target (Xtensa ESP32): blocks take the multiply-only scalar loop
+void IMUConverter::convertBlocks(const uint8_t* records, const size_t blocks, float* out) const
+{
+    convertScalar(records, blocks * BLOCK_RECORDS, out);
+}
+
+const char* IMUConverter::simdPath()
+{
+    return "scalar";
+}
+
+#endif
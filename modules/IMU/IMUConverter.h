@@ -0,0 +1,61 @@
+//
+// Created by stikper on 16.06.25.
+//
+
+#ifndef IMUCONVERTER_H
+#define IMUCONVERTER_H
+
+#include <cstddef>
+#include <cstdint>
+
+
+// MPU6050 raw records to SI units for whole FIFO bursts.
+// A record is 7 big-endian int16 in the ACCEL_XOUT_H..GYRO_ZOUT_L order: accel X/Y/Z, temperature, gyro X/Y/Z.
+// The output keeps that order as 7 floats per record: m/s², °C, °/s.
+// Every value is raw * scale + offset with the per-channel factors computed once by setScales and setCorrection,
+// which lets the block go through SSE2/NEON four values at a time with no per-record work.
+// Calibration is folded into the same two factors: (raw * sensor_scale + sensor_offset - bias) * gain.
+class IMUConverter
+{
+public:
+    static constexpr size_t CHANNELS = 7;
+    static constexpr size_t RECORD_SIZE = CHANNELS * 2;
+
+    static constexpr size_t ACCEL = 0; // Channel offsets inside an output record
+    static constexpr size_t TEMP = 3;
+    static constexpr size_t GYRO = 4;
+
+private:
+    // Four records are 28 values, a whole number of 4-lane vectors: factors repeat every 7 vectors
+    static constexpr size_t BLOCK_RECORDS = 4;
+    static constexpr size_t BLOCK_VALUES = BLOCK_RECORDS * CHANNELS;
+
+    float sensor_scale[CHANNELS] = {};
+    float sensor_offset[CHANNELS] = {};
+    float gain[CHANNELS] = {};
+    float bias[CHANNELS] = {};
+
+    alignas(16) float scale[BLOCK_VALUES];
+    alignas(16) float offset[BLOCK_VALUES];
+
+    void rebuild();
+    void convertBlocks(const uint8_t* records, size_t blocks, float* out) const;
+
+public:
+    IMUConverter();
+
+    // ACCEL_CONFIG AFS_SEL and GYRO_CONFIG FS_SEL
+    void setScales(uint8_t accel_scale, uint8_t gyro_scale);
+    // Per-channel calibration in SI units, CHANNELS values each. nullptr restores 1 and 0
+    void setCorrection(const float* channel_gain, const float* channel_bias);
+
+    // out holds count * CHANNELS floats
+    void convert(const uint8_t* records, size_t count, float* out) const;
+    void convertScalar(const uint8_t* records, size_t count, float* out) const;
+
+    // Name of the vector path convert() uses, "scalar" if there is none
+    static const char* simdPath();
+};
+
+
+#endif //IMUCONVERTER_H
@@ -4,14 +4,14 @@
 
 #include "MPU6050.h"
 
-#include <cmath>
-
 #include <esp_log.h>
 #include <esp_timer.h>
+#include <driver/gpio.h>
 #include <driver/i2c.h>
 #include <driver/i2c_master.h>
+#include <sdkconfig.h>
 
-MPU6050::MPU6050(): cfg{}
+MPU6050::MPU6050(): cfg{}, calibration("mpu6050")
 {
     TAG = "MPU6050";
     ESP_LOGI(TAG.data(), "Initializing...");
@@ -25,7 +25,13 @@ MPU6050::MPU6050(): cfg{}
     cfg.i2c_port_num = I2C_NUM_0;
     cfg.i2c_sda = GPIO_NUM_18;
     cfg.i2c_scl = GPIO_NUM_5;
-    cfg.rate = 100;
+    cfg.int_gpio = static_cast<gpio_num_t>(CONFIG_IMU_INT_GPIO);
+    // Data ready needs the INT pin, without it the FIFO keeps every sample on the sensor clock
+    cfg.acquisition_mode = cfg.int_gpio == GPIO_NUM_NC ? ACQUIRE_FIFO : ACQUIRE_DRDY;
+    cfg.profile = PROFILE_CONTROL;
+    cfg.fifo_read_period_ms = 10;
+    cfg.calibration_validate_ms = 200;
+    cfg.calibration_full_ms = 2000;
     cfg.imu_task_priority = 11;
     cfg.imu_task_stack_size = 4096;
     cfg.accel_scale = 3; // ±8g
@@ -33,6 +39,28 @@ MPU6050::MPU6050(): cfg{}
 
     imu_task_handle = nullptr;
 
+    sample_period_us = 1000;
+    last_sample_time = -1;
+    fifo_overflows = 0;
+
+    drdy_time = -1;
+    drdy_count.store(0, std::memory_order_relaxed);
+    drdy_missed = 0;
+    drdy_handled = 0;
+    drdy_attached = false;
+
+    async_bus = false;
+    transfer_waiter = nullptr;
+    async_reg = REG_ACCEL_XOUT_H;
+    async_sample_time = -1;
+    async_busy = false;
+    async_ok.store(false, std::memory_order_relaxed);
+    async_errors = 0;
+
+    shared_bus = nullptr;
+    bus_device = -1;
+    bus_read_id = -1;
+
     bus_handle = nullptr;
     dev_handle = nullptr;
 
@@ -48,6 +76,33 @@ MPU6050::~MPU6050()
 
 esp_err_t MPU6050::initI2C()
 {
+    if (cfg.acquisition_mode == ACQUIRE_BUS)
+    {
+        shared_bus = I2CBus::get(cfg.i2c_port_num, cfg.i2c_sda, cfg.i2c_scl);
+        if (shared_bus == nullptr)
+        {
+            ESP_LOGE(TAG.data(), "Failed to get I2C bus scheduler");
+            return ESP_FAIL;
+        }
+        if (bus_device >= 0) return ESP_OK;
+
+        const esp_err_t ret = shared_bus->addDevice(0x68, 400000, &bus_device);
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG.data(), "Failed to add I2C device");
+            return ESP_FAIL;
+        }
+        ESP_LOGI(TAG.data(), "I2C device added to the bus scheduler");
+        return ESP_OK;
+    }
+
+    // Scheduled transfers are blocking, queued ones of our own would run in between
+    if (I2CBus::owns(cfg.i2c_port_num))
+    {
+        ESP_LOGE(TAG.data(), "I2C port belongs to the bus scheduler, use ACQUIRE_BUS");
+        return ESP_FAIL;
+    }
+
     // Check if this I2C already initialized
     esp_err_t ret = i2c_master_get_bus_handle(cfg.i2c_port_num, &bus_handle);
 
@@ -60,6 +115,7 @@ esp_err_t MPU6050::initI2C()
         i2c_mst_config.sda_io_num = cfg.i2c_sda;
         i2c_mst_config.scl_io_num = cfg.i2c_scl;
         i2c_mst_config.glitch_ignore_cnt = 7;
+        i2c_mst_config.trans_queue_depth = I2C_QUEUE_DEPTH;
         i2c_mst_config.flags.enable_internal_pullup = true;
 
         ret = i2c_new_master_bus(&i2c_mst_config, &bus_handle);
@@ -84,6 +140,14 @@ esp_err_t MPU6050::initI2C()
         return ESP_FAIL;
     }
 
+    // Registration fails on a bus without a transaction queue, e.g. one created elsewhere
+    i2c_master_event_callbacks_t callbacks = {};
+    callbacks.on_trans_done = transferDoneHandler;
+    ret = i2c_master_register_event_callbacks(dev_handle, &callbacks, this);
+    async_bus = ret == ESP_OK;
+    if (!async_bus)
+        ESP_LOGW(TAG.data(), "Asynchronous I2C unavailable (%d), sample reads block the task", ret);
+
     ESP_LOGI(TAG.data(), "I2C device initialized");
     return ESP_OK;
 }
@@ -92,6 +156,22 @@ esp_err_t MPU6050::removeI2C()
 {
     //TODO: remove mst or not??
 
+    if (shared_bus != nullptr)
+    {
+        // Device stays registered with the bus, only the sample read leaves the timeline
+        esp_err_t ret = ESP_OK;
+        if (bus_read_id >= 0) ret = shared_bus->removePeriodic(bus_read_id);
+        bus_read_id = -1;
+        return ret;
+    }
+
+    if (async_bus)
+    {
+        // Transfer still queued would complete into a removed device
+        i2c_master_bus_wait_all_done(bus_handle, 100);
+        async_busy = false;
+    }
+
     esp_err_t ret = i2c_master_bus_rm_device(dev_handle);
     if (ret != ESP_OK)
     {
@@ -103,70 +183,421 @@ esp_err_t MPU6050::removeI2C()
     return ESP_OK;
 }
 
-esp_err_t MPU6050::configMPU6050() const
+esp_err_t MPU6050::transfer(const uint8_t* write, const size_t write_length, uint8_t* read, const size_t read_length)
+{
+    if (shared_bus != nullptr)
+        return shared_bus->transfer(bus_device, write, write_length, read, read_length, pdMS_TO_TICKS(100));
+
+    // 9 clocks per byte, a long FIFO burst alone outlasts a fixed timeout
+    const int timeout_ms = I2C_TIMEOUT_MS +
+        static_cast<int>((write_length + read_length + 2) * 9 * 1000 / cfg.i2c_freq);
+
+    transfer_waiter = xTaskGetCurrentTaskHandle();
+    esp_err_t ret = read_length == 0
+                        ? i2c_master_transmit(dev_handle, write, write_length, timeout_ms)
+                        : i2c_master_transmit_receive(dev_handle, write, write_length, read, read_length, timeout_ms);
+    if (ret != ESP_OK || !async_bus) return ret;
+
+    // Only queued so far, the buffers may be on the caller's stack
+    const int64_t deadline = esp_timer_get_time() + static_cast<int64_t>(timeout_ms) * 1000;
+    uint32_t events = 0;
+    while (!(events & NOTIFY_TRANSFER_DONE))
+    {
+        // Data ready edges wake the wait too, their bit stays set for the sample loop
+        const int64_t left_us = deadline - esp_timer_get_time();
+        if (left_us <= 0 ||
+            xTaskNotifyWait(0, NOTIFY_TRANSFER_DONE, &events, pdMS_TO_TICKS(left_us / 1000) + 1) != pdTRUE)
+        {
+            // Nothing may touch the buffers after the return, a late completion bit is dropped with it
+            i2c_master_bus_wait_all_done(bus_handle, timeout_ms);
+            ulTaskNotifyValueClear(nullptr, NOTIFY_TRANSFER_DONE);
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+
+    return async_ok.load(std::memory_order_acquire) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t MPU6050::writeRegister(const uint8_t reg, const uint8_t value)
 {
-    // Unset sleep mode
-    uint8_t buf[2] = {0x6B, 0x00};
-    esp_err_t ret = i2c_master_transmit(dev_handle, buf, 2, -1);
+    const uint8_t buf[2] = {reg, value};
+    return transfer(buf, 2, nullptr, 0);
+}
+
+esp_err_t MPU6050::readRegisters(const uint8_t reg, uint8_t* data, const size_t length)
+{
+    return transfer(&reg, 1, data, length);
+}
+
+esp_err_t MPU6050::configMPU6050()
+{
+    // Interrupt and FIFO routing follow the acquisition mode
+    uint8_t fifo_en = 0x00;
+    uint8_t int_enable = 0x00;
+    if (cfg.acquisition_mode == ACQUIRE_FIFO || cfg.acquisition_mode == ACQUIRE_BUS)
+    {
+        fifo_en = FIFO_EN_SAMPLE;
+        int_enable = INT_FIFO_OFLOW;
+    }
+    else if (cfg.acquisition_mode == ACQUIRE_DRDY)
+    {
+        int_enable = INT_DATA_RDY;
+    }
+
+    // Wakes the chip from sleep, the clock switch goes first so the rest runs on the PLL
+    const uint8_t writes[][2] = {
+        {REG_PWR_MGMT_1, static_cast<uint8_t>(cfg.profile.clock & 0x07)},
+        {REG_SMPLRT_DIV, cfg.profile.sample_div},
+        {REG_CONFIG, static_cast<uint8_t>(cfg.profile.dlpf & 0x07)},
+        {REG_GYRO_CONFIG, static_cast<uint8_t>(cfg.gyro_scale << 3)},
+        {REG_ACCEL_CONFIG, static_cast<uint8_t>(cfg.accel_scale << 3)},
+        {REG_FIFO_EN, fifo_en},
+        {REG_INT_PIN_CFG, INT_PIN_PULSE}, // Pulse instead of a latched level: nothing has to be read to rearm the pin
+        {REG_INT_ENABLE, int_enable},
+    };
+
+    uint8_t who_am_i;
+    esp_err_t ret = readRegisters(REG_WHO_AM_I, &who_am_i, 1);
+    if (ret != ESP_OK) return ret;
+    if ((who_am_i & 0x7E) != WHO_AM_I_VALUE)
+    {
+        ESP_LOGE(TAG.data(), "Unexpected WHO_AM_I 0x%02x", who_am_i);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    for (const auto& write : writes)
+    {
+        ret = writeRegister(write[0], write[1]);
+        if (ret != ESP_OK) return ret;
+    }
+
+    ret = verifyRegisters(writes, sizeof(writes) / sizeof(writes[0]));
+    if (ret != ESP_OK) return ret;
+
+    converter.setScales(cfg.accel_scale, cfg.gyro_scale);
+
+    sample_period_us = static_cast<int64_t>(1000000.0f / getSampleRate());
+    ESP_LOGI(TAG.data(), "Profile %s: %.0f Hz, DLPF_CFG %u", cfg.profile.name, getSampleRate(),
+             cfg.profile.dlpf & 0x07);
+
+    if (fifo_en != 0) return resetFIFO();
+
+    return writeRegister(REG_USER_CTRL, 0x00);
+}
+
+esp_err_t MPU6050::verifyRegisters(const uint8_t (*writes)[2], const size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t value;
+        const esp_err_t ret = readRegisters(writes[i][0], &value, 1);
+        if (ret != ESP_OK) return ret;
+
+        if (value != writes[i][1])
+        {
+            ESP_LOGE(TAG.data(), "Register 0x%02x reads 0x%02x, wrote 0x%02x", writes[i][0], value, writes[i][1]);
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t MPU6050::resetFIFO()
+{
+    esp_err_t ret = writeRegister(REG_USER_CTRL, USER_CTRL_FIFO_RESET);
     if (ret != ESP_OK) return ret;
 
-    // Config accelerometer
-    buf[0] = 0x1C;
-    buf[1] = cfg.accel_scale << 3;
-    ret = i2c_master_transmit(dev_handle, buf, 2, -1);
+    ret = writeRegister(REG_USER_CTRL, USER_CTRL_FIFO_EN);
     if (ret != ESP_OK) return ret;
 
-    // Config gyroscope
-    buf[0] = 0x1B;
-    buf[1] = cfg.gyro_scale << 3;
-    ret = i2c_master_transmit(dev_handle, buf, 2, -1);
+    // Reading clears a stale overflow flag
+    uint8_t status;
+    ret = readRegisters(REG_INT_STATUS, &status, 1);
+    last_sample_time = -1;
+    return ret;
+}
+
+void IRAM_ATTR MPU6050::drdyIsrHandler(void* arg)
+{
+    auto* imu = static_cast<MPU6050*>(arg);
+
+    imu->drdy_time = esp_timer_get_time();
+    imu->drdy_count.fetch_add(1, std::memory_order_release);
+
+    if (imu->imu_task_handle == nullptr) return;
+
+    BaseType_t woken = pdFALSE;
+    xTaskNotifyFromISR(imu->imu_task_handle, NOTIFY_DRDY, eSetBits, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+bool IRAM_ATTR MPU6050::transferDoneHandler(i2c_master_dev_handle_t, const i2c_master_event_data_t* event,
+                                            void* arg)
+{
+    auto* imu = static_cast<MPU6050*>(arg);
+
+    // No FPU in interrupt context: a sample record is converted and published by the task
+    imu->async_ok.store(event->event == I2C_EVENT_DONE, std::memory_order_release);
+    if (imu->transfer_waiter == nullptr) return false;
+
+    BaseType_t woken = pdFALSE;
+    xTaskNotifyFromISR(imu->transfer_waiter, NOTIFY_TRANSFER_DONE, eSetBits, &woken);
+    return woken == pdTRUE;
+}
+
+esp_err_t MPU6050::attachInterrupt()
+{
+    if (cfg.int_gpio == GPIO_NUM_NC) return ESP_ERR_NOT_FOUND;
+
+    const gpio_config_t io_config = {
+        .pin_bit_mask = 1ULL << cfg.int_gpio,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_ENABLE,
+        .intr_type = GPIO_INTR_POSEDGE
+    };
+    esp_err_t ret = gpio_config(&io_config);
+    if (ret != ESP_OK) return ret;
+
+    // Service may already be installed by another module
+    ret = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) return ret;
+
+    ret = gpio_isr_handler_add(cfg.int_gpio, drdyIsrHandler, this);
     if (ret != ESP_OK) return ret;
 
+    drdy_attached = true;
+    ESP_LOGI(TAG.data(), "Sampling on data ready interrupt, GPIO %d", cfg.int_gpio);
     return ESP_OK;
 }
 
+esp_err_t MPU6050::detachInterrupt()
+{
+    if (!drdy_attached) return ESP_OK;
+
+    drdy_attached = false;
+    return gpio_isr_handler_remove(cfg.int_gpio);
+}
+
+esp_err_t MPU6050::fallbackToFIFO()
+{
+    detachInterrupt();
+    if (async_busy)
+    {
+        // Its completion would end the first configuration transfer early
+        i2c_master_bus_wait_all_done(bus_handle, 100);
+        ulTaskNotifyValueClear(nullptr, NOTIFY_TRANSFER_DONE);
+        async_busy = false;
+    }
+    cfg.acquisition_mode = ACQUIRE_FIFO;
+
+    // Task loop picks the new mode up on its next pass
+    const esp_err_t ret = configMPU6050();
+    if (ret != ESP_OK) ESP_LOGE(TAG.data(), "Failed to configure FIFO: %d", ret);
+    return ret;
+}
+
 esp_err_t MPU6050::getData()
 {
-    float accel[3];
-    float gyro[3];
-    float temp[1];
+    // Sensor sampled within the last period, the transfer end is further away from it
+    const int64_t timestamp = esp_timer_get_time();
 
-    uint8_t data[14];
-    uint8_t data_reg = 0x3B;
-    //TODO!!! FIX CRASHES
-    //TODO!!! Interrupt wdt timeout on CPU0
-    esp_err_t ret = i2c_master_transmit_receive(dev_handle, &data_reg, 1, data, 14, 10);
+    uint8_t data[RECORD_SIZE];
+    esp_err_t ret = readRegisters(REG_ACCEL_XOUT_H, data, RECORD_SIZE);
     if (ret != ESP_OK) return ret;
 
-    int64_t timestamp = esp_timer_get_time();
+    publishSample(data, timestamp);
+
+    return ESP_OK;
+}
+
+esp_err_t MPU6050::submitRead(const int64_t timestamp)
+{
+    if (!async_bus)
+    {
+        // Output registers are refreshed only while the bus is idle, an edge during the read is the next sample
+        uint8_t data[RECORD_SIZE];
+        const esp_err_t ret = readRegisters(REG_ACCEL_XOUT_H, data, RECORD_SIZE);
+        if (ret != ESP_OK) return ret;
+
+        publishSample(data, timestamp);
+        return ESP_OK;
+    }
+
+    // Returns once the transfer is queued, completion comes as NOTIFY_TRANSFER_DONE
+    async_sample_time = timestamp;
+    async_busy = true;
+    transfer_waiter = xTaskGetCurrentTaskHandle();
+    const esp_err_t ret = i2c_master_transmit_receive(dev_handle, &async_reg, 1, async_record, RECORD_SIZE,
+                                                      I2C_TIMEOUT_MS);
+    if (ret != ESP_OK) async_busy = false;
+    return ret;
+}
+
+void MPU6050::busReadCallback(void* arg, const esp_err_t status, const uint8_t* data, size_t, const int64_t time)
+{
+    auto* imu = static_cast<MPU6050*>(arg);
+
+    // Bus task context. The frames run on esp_timer, not the sensor clock: the FIFO keeps every sample
+    // exactly once and its count dates them, the records are read right after within the same slot
+    if (status != ESP_OK)
+    {
+        imu->async_errors++;
+        return;
+    }
+    if (imu->drainFIFO(data[0] << 8 | data[1], time, BUS_READ_SAMPLES + 1) != ESP_OK) imu->async_errors++;
+}
+
+esp_err_t MPU6050::readDataReady()
+{
+    uint32_t events = 0;
+    const TickType_t timeout = pdMS_TO_TICKS(DRDY_LOST_PERIODS * sample_period_us / 1000) + 1;
+    if (xTaskNotifyWait(0, NOTIFY_DRDY | NOTIFY_TRANSFER_DONE, &events, timeout) != pdTRUE)
+    {
+        // Pulled down input stays low without a sensor behind it
+        ESP_LOGW(TAG.data(), "No data ready interrupt on GPIO %d, using FIFO bursts", cfg.int_gpio);
+        return fallbackToFIFO();
+    }
+
+    if ((events & NOTIFY_TRANSFER_DONE) && async_busy)
+    {
+        async_busy = false;
+        if (async_ok.load(std::memory_order_acquire)) publishSample(async_record, async_sample_time);
+        else async_errors++;
+    }
 
-    auto ax = static_cast<int16_t>(data[0] << 8 | data[1]);
-    auto ay = static_cast<int16_t>(data[2] << 8 | data[3]);
-    auto az = static_cast<int16_t>(data[4] << 8 | data[5]);
+    if (!(events & NOTIFY_DRDY)) return ESP_OK;
 
-    auto t = static_cast<int16_t>(data[6] << 8 | data[7]);
+    // Edges since the last wake, the registers only hold the newest of them
+    const uint32_t n = drdy_count.load(std::memory_order_acquire);
+    const int64_t timestamp = drdy_time;
+    if (drdy_count.load(std::memory_order_acquire) != n) return ESP_OK; // Next edge is already pending
+    const uint32_t edges = n - drdy_handled;
+    drdy_handled = n;
+    if (edges > 1) drdy_missed += edges - 1;
 
-    auto gx = static_cast<int16_t>(data[8] << 8 | data[9]);
-    auto gy = static_cast<int16_t>(data[10] << 8 | data[11]);
-    auto gz = static_cast<int16_t>(data[12] << 8 | data[13]);
+    if (async_busy)
+    {
+        // Previous read still on the bus, this sample is overwritten before it could start
+        drdy_missed++;
+        return ESP_OK;
+    }
 
-    const float accel_div = 16384.0f / powf(2.0f, cfg.accel_scale);
-    accel[0] = static_cast<float>(ax) / accel_div * 9.81f;
-    accel[1] = static_cast<float>(ay) / accel_div * 9.81f;
-    accel[2] = static_cast<float>(az) / accel_div * 9.81f;
+    return submitRead(timestamp);
+}
 
-    const float gyro_div = 131.0f / powf(2.0f, cfg.gyro_scale);
-    gyro[0] = static_cast<float>(gx) / gyro_div;
-    gyro[1] = static_cast<float>(gy) / gyro_div;
-    gyro[2] = static_cast<float>(gz) / gyro_div;
+esp_err_t MPU6050::readFIFO()
+{
+    uint8_t count_data[2];
+    const esp_err_t ret = readRegisters(REG_FIFO_COUNT_H, count_data, 2);
+    if (ret != ESP_OK) return ret;
 
-    temp[0] = static_cast<float>(t) / 340.0f + 36.53f;
+    return drainFIFO(count_data[0] << 8 | count_data[1], esp_timer_get_time(), SIZE_MAX);
+}
 
-    updateData(timestamp, accel, gyro, temp);
+esp_err_t MPU6050::drainFIFO(const size_t count, const int64_t now, const size_t max_samples)
+{
+    esp_err_t ret;
+
+    // Full FIFO drops samples and a partial record breaks the alignment, both need a reset
+    bool overflow = count % RECORD_SIZE != 0;
+    if (!overflow && count > FIFO_SIZE - 2 * RECORD_SIZE)
+    {
+        uint8_t status;
+        ret = readRegisters(REG_INT_STATUS, &status, 1);
+        if (ret != ESP_OK) return ret;
+        overflow = (status & INT_FIFO_OFLOW) != 0;
+    }
+    if (overflow)
+    {
+        fifo_overflows++;
+        ESP_LOGW(TAG.data(), "FIFO overflow, %u bytes lost", static_cast<unsigned>(count));
+        return resetFIFO();
+    }
+
+    const size_t samples = count / RECORD_SIZE;
+    if (samples == 0) return ESP_OK;
+    // Oldest first, the rest waits for the next call
+    const size_t take = samples < max_samples ? samples : max_samples;
+
+    // Sensor produced the newest buffered sample within one period before the count was read.
+    // Times continue from the previous burst and are only pulled back into that window
+    int64_t newest = last_sample_time < 0
+                         ? now
+                         : last_sample_time + static_cast<int64_t>(samples) * sample_period_us;
+    if (newest > now) newest = now;
+    else if (newest < now - sample_period_us) newest = now - sample_period_us;
+
+    size_t done = 0;
+    while (done < take)
+    {
+        const size_t burst = take - done < FIFO_BURST_SAMPLES ? take - done : FIFO_BURST_SAMPLES;
+        ret = readRegisters(REG_FIFO_R_W, fifo_buffer, burst * RECORD_SIZE);
+        if (ret != ESP_OK) return ret;
+
+        converter.convert(fifo_buffer, burst, fifo_si);
+        for (size_t i = 0; i < burst; i++, done++)
+        {
+            last_sample_time = newest - static_cast<int64_t>(samples - 1 - done) * sample_period_us;
+            publishConverted(fifo_si + i * IMUConverter::CHANNELS, last_sample_time);
+        }
+        calibration.apply(converter, fifo_si[(burst - 1) * IMUConverter::CHANNELS + IMUConverter::TEMP]);
+    }
 
     return ESP_OK;
 }
 
+void MPU6050::publishSample(const uint8_t* record, const int64_t timestamp)
+{
+    float si[IMUConverter::CHANNELS];
+    converter.convertScalar(record, 1, si);
+    publishConverted(si, timestamp);
+    calibration.apply(converter, si[IMUConverter::TEMP]);
+}
+
+void MPU6050::publishConverted(const float* si, const int64_t timestamp)
+{
+    updateData(timestamp, si + IMUConverter::ACCEL, si + IMUConverter::GYRO, si + IMUConverter::TEMP);
+    calibration.feed(si);
+}
+
+uint32_t MPU6050::getFifoOverflows() const
+{
+    return fifo_overflows;
+}
+
+uint32_t MPU6050::getMissedSamples() const
+{
+    return drdy_missed;
+}
+
+uint32_t MPU6050::getReadErrors() const
+{
+    return async_errors;
+}
+
+bool MPU6050::isCalibrated() const
+{
+    return calibration.isReady();
+}
+
+IMUCalibration::state_t MPU6050::getCalibrationState() const
+{
+    return calibration.getState();
+}
+
+esp_err_t MPU6050::setCalibration(const IMUCalibration::Coefficients& coefficients)
+{
+    return calibration.setCoefficients(coefficients);
+}
+
+float MPU6050::getSampleRate() const
+{
+    const uint8_t dlpf = cfg.profile.dlpf & 0x07;
+    const float gyro_rate = dlpf == 0 || dlpf == 7 ? 8000.0f : 1000.0f;
+    return gyro_rate / static_cast<float>(1 + cfg.profile.sample_div);
+}
+
 void MPU6050::imuTaskWrapper(void* param)
 {
     auto* imu = static_cast<MPU6050*>(param);
@@ -176,15 +607,32 @@ void MPU6050::imuTaskWrapper(void* param)
 
 _Noreturn void MPU6050::imuTask()
 {
+    TickType_t last_wake = xTaskGetTickCount();
+    // Edges from before the task existed are not missed samples
+    drdy_handled = drdy_count.load(std::memory_order_acquire);
     while (true)
     {
-        const auto delay = static_cast<int>(1.0f / static_cast<float>(cfg.rate) * 1000);
-        if (running)
+        if (cfg.acquisition_mode == ACQUIRE_DRDY)
+        {
+            // Sensor clock sets the rate, the task only waits for it
+            if (running) readDataReady();
+            else vTaskDelay(pdMS_TO_TICKS(10));
+            continue;
+        }
+
+        if (cfg.acquisition_mode == ACQUIRE_FIFO)
         {
-            getData();
-            vTaskDelay(pdMS_TO_TICKS(delay));
+            // FIFO holds ~70 samples, the period only sets how many come per burst
+            vTaskDelay(pdMS_TO_TICKS(cfg.fifo_read_period_ms));
+            if (running) readFIFO();
+            continue;
         }
-        vTaskDelay(pdMS_TO_TICKS(10));
+
+        // Fixed wake grid, still quantized to the tick
+        TickType_t period = pdMS_TO_TICKS(sample_period_us / 1000);
+        if (period == 0) period = 1;
+        vTaskDelayUntil(&last_wake, period);
+        if (running) getData();
     }
 }
 
@@ -202,6 +650,16 @@ esp_err_t MPU6050::start()
     }
     ESP_LOGI(TAG.data(), "I2C initialized");
 
+    if (cfg.acquisition_mode == ACQUIRE_DRDY)
+    {
+        ret = attachInterrupt();
+        if (ret != ESP_OK)
+        {
+            ESP_LOGW(TAG.data(), "Data ready interrupt unavailable (%d), using FIFO bursts", ret);
+            cfg.acquisition_mode = ACQUIRE_FIFO;
+        }
+    }
+
     ESP_LOGI(TAG.data(), "MPU6050 configuring");
     ret = configMPU6050();
     if (ret != ESP_OK)
@@ -211,6 +669,43 @@ esp_err_t MPU6050::start()
     }
     ESP_LOGI(TAG.data(), "MPU6050 configured");
 
+    // Stored coefficients correct samples right away, the window only confirms them
+    ret = calibration.load();
+    if (ret != ESP_OK) ESP_LOGW(TAG.data(), "No stored calibration: %d", ret);
+    calibration.apply(converter, calibration.getCoefficients().reference_temp);
+    const float samples_per_ms = getSampleRate() / 1000.0f;
+    calibration.begin(static_cast<size_t>(static_cast<float>(cfg.calibration_validate_ms) * samples_per_ms),
+                      static_cast<size_t>(static_cast<float>(cfg.calibration_full_ms) * samples_per_ms));
+
+    if (cfg.acquisition_mode == ACQUIRE_BUS)
+    {
+        // Top priority on the bus, so the read opens every frame it runs in.
+        // One record more than a period produces, so a backlog drains and sensor clock drift is absorbed
+        I2CBus::periodic_t read = {};
+        read.name = "mpu6050";
+        read.device = bus_device;
+        read.reg = REG_FIFO_COUNT_H;
+        read.length = 2;
+        read.period_us = static_cast<uint32_t>(sample_period_us * BUS_READ_SAMPLES);
+        read.deadline_us = 0;
+        read.priority = 255;
+        read.follow_up = static_cast<uint8_t>((BUS_READ_SAMPLES + 1) * RECORD_SIZE);
+        read.callback = busReadCallback;
+        read.arg = this;
+
+        running = true;
+        ret = shared_bus->addPeriodic(read, &bus_read_id);
+        if (ret != ESP_OK)
+        {
+            running = false;
+            ESP_LOGE(TAG.data(), "Failed to schedule sample read");
+            return ESP_FAIL;
+        }
+
+        ESP_LOGI(TAG.data(), "MPU6050 started on the shared bus");
+        return ESP_OK;
+    }
+
     ESP_LOGI(TAG.data(), "Creating update task");
     const BaseType_t xReturned_2 = xTaskCreate(
         imuTaskWrapper,
@@ -240,6 +735,9 @@ esp_err_t MPU6050::stop()
 
     running = false;
 
+    // ISR notifies the task, it must be gone before the task is
+    detachInterrupt();
+
     if (imu_task_handle != nullptr)
     {
         vTaskDelay(pdMS_TO_TICKS(100));
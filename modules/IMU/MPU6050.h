@@ -5,23 +5,62 @@
 #ifndef MPU6050_H
 #define MPU6050_H
 
+#include <atomic>
+#include <driver/i2c_master.h>
 #include <driver/i2c_types.h>
+#include <esp_attr.h>
 #include <soc/gpio_num.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 
 #include "IMU/IIMUModule.h"
+#include "IMU/IMUCalibration.h"
+#include "IMU/IMUConverter.h"
+#include "I2C/I2CBus.h"
 
 
 
 class MPU6050 final : public IIMUModule
 {
 public:
+    enum acquisition_mode_t
+    {
+        ACQUIRE_POLL, // One register read per sample from the task loop
+        ACQUIRE_FIFO, // Sensor buffers samples at its own rate, the task reads them in bursts
+        ACQUIRE_DRDY, // Data ready interrupt wakes the task for every sample, falls back to FIFO if no edges arrive
+        ACQUIRE_BUS   // Shared bus scheduler drains the FIFO at a fixed offset in its frame, no IMU task
+    };
+
+    enum clock_source_t : uint8_t
+    {
+        CLOCK_INTERNAL = 0,  // 8 MHz relaxation oscillator, drifts with temperature
+        CLOCK_PLL_GYRO_X = 1 // PLL locked to the X gyro drive, the datasheet recommended source
+    };
+
+    // Sensor side filtering and decimation, the chip does the anti-alias work before the samples reach the bus
+    struct mpu6050_profile_t
+    {
+        const char* name;
+        uint8_t dlpf;          // CONFIG DLPF_CFG, 0 and 7 run the gyro at 8 kHz instead of 1 kHz
+        uint8_t sample_div;    // SMPLRT_DIV, sample rate = gyro output rate / (1 + sample_div)
+        clock_source_t clock;  // PWR_MGMT_1 CLKSEL
+    };
+
+    static constexpr mpu6050_profile_t PROFILE_CONTROL = {"control", 1, 0, CLOCK_PLL_GYRO_X}; // 1 kHz, 188 Hz DLPF
+    static constexpr mpu6050_profile_t PROFILE_LOGGING = {"logging", 3, 4, CLOCK_PLL_GYRO_X}; // 200 Hz, 42 Hz DLPF
+
     struct mpu6050_config_t
     {
+        acquisition_mode_t acquisition_mode;
         int i2c_freq;
         i2c_port_t i2c_port_num;
         gpio_num_t i2c_sda;
         gpio_num_t i2c_scl;
-        int rate;
+        gpio_num_t int_gpio;     // MPU6050 INT pin, GPIO_NUM_NC if not connected
+        mpu6050_profile_t profile;
+        int fifo_read_period_ms; // ACQUIRE_FIFO burst period, must stay well below the FIFO fill time
+        int calibration_validate_ms; // Stationary window confirming stored calibration at start
+        int calibration_full_ms;     // Stationary window averaging a new gyro bias
         int imu_task_priority;
         int imu_task_stack_size;
         uint8_t accel_scale;
@@ -32,6 +71,76 @@ private:
     mpu6050_config_t cfg;
     std::string TAG;
 
+    static constexpr uint8_t REG_SMPLRT_DIV = 0x19;
+    static constexpr uint8_t REG_CONFIG = 0x1A;
+    static constexpr uint8_t REG_GYRO_CONFIG = 0x1B;
+    static constexpr uint8_t REG_ACCEL_CONFIG = 0x1C;
+    static constexpr uint8_t REG_FIFO_EN = 0x23;
+    static constexpr uint8_t REG_INT_PIN_CFG = 0x37;
+    static constexpr uint8_t REG_INT_ENABLE = 0x38;
+    static constexpr uint8_t REG_INT_STATUS = 0x3A;
+    static constexpr uint8_t REG_ACCEL_XOUT_H = 0x3B;
+    static constexpr uint8_t REG_USER_CTRL = 0x6A;
+    static constexpr uint8_t REG_PWR_MGMT_1 = 0x6B;
+    static constexpr uint8_t REG_WHO_AM_I = 0x75;
+    static constexpr uint8_t REG_FIFO_COUNT_H = 0x72;
+    static constexpr uint8_t REG_FIFO_R_W = 0x74;
+
+    static constexpr uint8_t FIFO_EN_SAMPLE = 0xF8;    // Temperature, gyro X/Y/Z and accel
+    static constexpr uint8_t USER_CTRL_FIFO_EN = 0x40;
+    static constexpr uint8_t USER_CTRL_FIFO_RESET = 0x04;
+    static constexpr uint8_t INT_FIFO_OFLOW = 0x10;
+    static constexpr uint8_t INT_DATA_RDY = 0x01;
+    static constexpr uint8_t INT_PIN_PULSE = 0x00;     // Active high push-pull, 50 us pulse per sample
+    static constexpr uint8_t WHO_AM_I_VALUE = 0x68;
+
+    // FIFO record has the ACCEL_XOUT_H..GYRO_ZOUT_L layout: accel, temperature, gyro
+    static constexpr size_t RECORD_SIZE = IMUConverter::RECORD_SIZE;
+    static constexpr size_t FIFO_SIZE = 1024;
+    static constexpr size_t FIFO_BURST_SAMPLES = 16; // 224 bytes, ~5 ms at 400 kHz
+    static constexpr int64_t BUS_READ_SAMPLES = 2;   // ACQUIRE_BUS read period in sample periods
+
+    static constexpr int I2C_TIMEOUT_MS = 10; // Margin on top of the time the bytes take on the wire
+    static constexpr size_t I2C_QUEUE_DEPTH = 4; // Bus transaction queue, turns every transfer on the bus asynchronous
+
+    // Edges missing for this many sample periods: INT is not wired or on another pin
+    static constexpr int64_t DRDY_LOST_PERIODS = 20;
+
+    // Task notification bits
+    static constexpr uint32_t NOTIFY_DRDY = 1 << 0;
+    static constexpr uint32_t NOTIFY_TRANSFER_DONE = 1 << 1;
+
+    uint8_t fifo_buffer[FIFO_BURST_SAMPLES * RECORD_SIZE];
+    float fifo_si[FIFO_BURST_SAMPLES * IMUConverter::CHANNELS];
+    IMUConverter converter;
+    IMUCalibration calibration;
+    int64_t sample_period_us;
+    int64_t last_sample_time; // Reconstructed time of the newest sample read, -1 after a FIFO reset
+    uint32_t fifo_overflows;
+
+    // Written only by the data ready ISR: esp_timer time of the newest INT edge, published by drdy_count
+    int64_t drdy_time;
+    std::atomic<uint32_t> drdy_count;
+    uint32_t drdy_missed;
+    uint32_t drdy_handled; // drdy_count at the last edge the task saw
+    bool drdy_attached;
+
+    // A bus with a transaction queue only queues transfers and reports them through the completion callback.
+    // The buffers belong to the bus until then: configuration and FIFO reads wait for it, sample reads do not
+    bool async_bus; // false if the bus runs without a transaction queue
+    TaskHandle_t transfer_waiter; // Task the completion callback notifies
+    uint8_t async_reg;
+    uint8_t async_record[RECORD_SIZE];
+    int64_t async_sample_time;
+    bool async_busy;
+    std::atomic<bool> async_ok;
+    uint32_t async_errors;
+
+    // ACQUIRE_BUS: the port belongs to the bus scheduler and every transfer goes through it
+    I2CBus* shared_bus;
+    int bus_device;  // -1 until registered, kept across restarts
+    int bus_read_id; // Periodic sample read, -1 if none
+
     TaskHandle_t imu_task_handle;
 
     i2c_master_bus_handle_t bus_handle;
@@ -43,15 +152,49 @@ public:
     MPU6050();
     ~MPU6050() override;
 
+    // FIFO overflows and misaligned FIFO contents, each one loses the buffered samples
+    uint32_t getFifoOverflows() const;
+    // ACQUIRE_DRDY samples overwritten before the task read them
+    uint32_t getMissedSamples() const;
+    // Asynchronous or bus scheduled reads that ended with a NACK or a bus timeout
+    uint32_t getReadErrors() const;
+    // Sample rate the active profile programs, Hz
+    float getSampleRate() const;
+
+    // Corrections are applied from the first sample, ready once confirmed or recalibrated at rest
+    bool isCalibrated() const;
+    IMUCalibration::state_t getCalibrationState() const;
+    // Stores new coefficients in NVS, used from the next start
+    esp_err_t setCalibration(const IMUCalibration::Coefficients& coefficients);
+
 private:
     esp_err_t initI2C();
     esp_err_t removeI2C();
-    esp_err_t configMPU6050() const;
+    esp_err_t transfer(const uint8_t* write, size_t write_length, uint8_t* read, size_t read_length);
+    esp_err_t writeRegister(uint8_t reg, uint8_t value);
+    esp_err_t readRegisters(uint8_t reg, uint8_t* data, size_t length);
+    esp_err_t configMPU6050();
+    esp_err_t verifyRegisters(const uint8_t (*writes)[2], size_t count);
+    esp_err_t resetFIFO();
+    esp_err_t attachInterrupt();
+    esp_err_t detachInterrupt();
+    esp_err_t fallbackToFIFO();
+
+    static void IRAM_ATTR drdyIsrHandler(void* arg);
+    static bool IRAM_ATTR transferDoneHandler(i2c_master_dev_handle_t dev, const i2c_master_event_data_t* event,
+                                              void* arg);
+    esp_err_t submitRead(int64_t timestamp);
+    static void busReadCallback(void* arg, esp_err_t status, const uint8_t* data, size_t length, int64_t time);
 
     static void imuTaskWrapper(void* param);
     _Noreturn void imuTask();
 
     esp_err_t getData();
+    esp_err_t readFIFO();
+    esp_err_t drainFIFO(size_t count, int64_t now, size_t max_samples);
+    esp_err_t readDataReady();
+    void publishSample(const uint8_t* record, int64_t timestamp);
+    void publishConverted(const float* si, int64_t timestamp);
 
     esp_err_t start() override;
     esp_err_t stop() override;
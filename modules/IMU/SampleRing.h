@@ -0,0 +1,103 @@
+//
+// Created by stikper on 02.06.25.
+//
+
+#ifndef SAMPLERING_H
+#define SAMPLERING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+
+// Broadcast ring of complete samples with a single writer and any number of readers.
+// The writer never waits: it overwrites the oldest slot and publishes the new total count.
+// Every reader keeps its own cursor and copies everything past it in one call. Slots the writer may have
+// reused during the copy are dropped from the result and counted as lost, so no locks are needed on either side.
+template <typename T, size_t Capacity>
+class SampleRing
+{
+    static_assert(Capacity > 1 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    T slots[Capacity];
+    std::atomic<uint32_t> head; // Samples written so far, the next slot is head % Capacity
+
+public:
+    static constexpr size_t CAPACITY = Capacity;
+
+    // Reader position in the stream of samples
+    struct Cursor
+    {
+        uint32_t next = 0; // Sequence number of the next sample to read
+        uint32_t lost = 0; // Samples overwritten before this reader got to them
+    };
+
+    SampleRing()
+    {
+        head.store(0, std::memory_order_relaxed);
+    }
+
+    // Writer only
+    void push(const T& sample)
+    {
+        const uint32_t n = head.load(std::memory_order_relaxed);
+        // Slot must not become visible before the previous head, readers check for reuse against it
+        std::atomic_thread_fence(std::memory_order_release);
+        slots[n % Capacity] = sample;
+        head.store(n + 1, std::memory_order_release);
+    }
+
+    // Cursor that only sees samples pushed after this call
+    Cursor cursor() const
+    {
+        return {head.load(std::memory_order_acquire), 0};
+    }
+
+    uint32_t written() const
+    {
+        return head.load(std::memory_order_acquire);
+    }
+
+    // Copies the samples after the cursor, oldest first, and advances it past them.
+    // Returns how many were copied. With a short out span the rest stays for the next call
+    size_t readSince(Cursor& cursor, std::span<T> out) const
+    {
+        const uint32_t end = head.load(std::memory_order_acquire);
+        if (end - cursor.next > Capacity)
+        {
+            cursor.lost += end - cursor.next - Capacity;
+            cursor.next = end - Capacity;
+        }
+
+        uint32_t available = end - cursor.next;
+        if (available > out.size()) available = static_cast<uint32_t>(out.size());
+
+        for (uint32_t i = 0; i < available; i++)
+            out[i] = slots[(cursor.next + i) % Capacity];
+
+        // Writer may have reached the oldest copied slots meanwhile, including the one it is writing now.
+        // Those copies can be torn
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint32_t after = head.load(std::memory_order_relaxed);
+        uint32_t skip = 0;
+        if (after - cursor.next >= Capacity)
+        {
+            skip = after - cursor.next - Capacity + 1;
+            if (skip > available) skip = available;
+        }
+
+        if (skip > 0)
+        {
+            for (uint32_t i = skip; i < available; i++)
+                out[i - skip] = out[i];
+            cursor.lost += skip;
+        }
+
+        cursor.next += available;
+        return available - skip;
+    }
+};
+
+
+#endif //SAMPLERING_H
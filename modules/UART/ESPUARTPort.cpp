@@ -0,0 +1,109 @@
+//
+// Created by stikper on 18.05.25.
+//
+
+#include "ESPUARTPort.h"
+
+
+ESPUARTPort::ESPUARTPort()
+{
+    port_num = UART_NUM_0;
+    eventQueue = nullptr;
+    installed = false;
+}
+
+ESPUARTPort::~ESPUARTPort()
+{
+    close();
+}
+
+esp_err_t ESPUARTPort::open(const uart_port_config_t& config)
+{
+    // Config and install uart driver
+    const uart_config_t uart_config = {
+        .baud_rate = config.baud_rate,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT
+    };
+
+    port_num = config.port_num;
+    const bool events = config.event_queue_size > 0;
+    esp_err_t ret = uart_driver_install(port_num, config.rx_buffer_size, 0, config.event_queue_size,
+                                        events ? &eventQueue : nullptr, 0);
+    if (ret != ESP_OK) return ret;
+    installed = true;
+
+    ret = uart_param_config(port_num, &uart_config);
+    if (ret != ESP_OK) return ret;
+
+    ret = uart_set_pin(port_num, config.txd, config.rxd, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    return ret;
+}
+
+esp_err_t ESPUARTPort::close()
+{
+    if (!installed) return ESP_OK;
+
+    // Event queue is deleted by the driver
+    installed = false;
+    eventQueue = nullptr;
+    return uart_driver_delete(port_num);
+}
+
+QueueHandle_t ESPUARTPort::getEventQueue() const
+{
+    return eventQueue;
+}
+
+esp_err_t ESPUARTPort::setBaudRate(const int baud_rate)
+{
+    return uart_set_baudrate(port_num, baud_rate);
+}
+
+esp_err_t ESPUARTPort::enablePattern(const char pattern, const int queue_size)
+{
+    const esp_err_t ret = uart_enable_pattern_det_baud_intr(port_num, pattern, 1, 9, 0, 0);
+    if (ret != ESP_OK) return ret;
+
+    return uart_pattern_queue_reset(port_num, queue_size);
+}
+
+int ESPUARTPort::popPattern()
+{
+    return uart_pattern_pop_pos(port_num);
+}
+
+esp_err_t ESPUARTPort::setRxTimeout(const uint8_t symbols)
+{
+    return uart_set_rx_timeout(port_num, symbols);
+}
+
+int ESPUARTPort::read(void* buffer, const size_t length, const TickType_t timeout)
+{
+    return uart_read_bytes(port_num, buffer, length, timeout);
+}
+
+int ESPUARTPort::write(const void* data, const size_t length)
+{
+    return uart_write_bytes(port_num, data, length);
+}
+
+esp_err_t ESPUARTPort::waitTxDone(const TickType_t timeout)
+{
+    return uart_wait_tx_done(port_num, timeout);
+}
+
+size_t ESPUARTPort::getBufferedLength()
+{
+    size_t length = 0;
+    uart_get_buffered_data_len(port_num, &length);
+    return length;
+}
+
+esp_err_t ESPUARTPort::flushInput()
+{
+    return uart_flush_input(port_num);
+}
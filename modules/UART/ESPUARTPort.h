@@ -0,0 +1,38 @@
+//
+// Created by stikper on 18.05.25.
+//
+
+#ifndef ESPUARTPORT_H
+#define ESPUARTPORT_H
+
+#include "IUARTPort.h"
+
+
+class ESPUARTPort final : public IUARTPort
+{
+    uart_port_t port_num;
+    QueueHandle_t eventQueue;
+    bool installed;
+
+public:
+    ESPUARTPort();
+    ~ESPUARTPort() override;
+
+    esp_err_t open(const uart_port_config_t& config) override;
+    esp_err_t close() override;
+    QueueHandle_t getEventQueue() const override;
+
+    esp_err_t setBaudRate(int baud_rate) override;
+    esp_err_t enablePattern(char pattern, int queue_size) override;
+    int popPattern() override;
+    esp_err_t setRxTimeout(uint8_t symbols) override;
+
+    int read(void* buffer, size_t length, TickType_t timeout) override;
+    int write(const void* data, size_t length) override;
+    esp_err_t waitTxDone(TickType_t timeout) override;
+    size_t getBufferedLength() override;
+    esp_err_t flushInput() override;
+};
+
+
+#endif //ESPUARTPORT_H
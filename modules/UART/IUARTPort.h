@@ -0,0 +1,53 @@
+//
+// Created by stikper on 18.05.25.
+//
+
+#ifndef IUARTPORT_H
+#define IUARTPORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <driver/uart.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+
+// UART as used by the GPS driver: ESP-IDF driver on target, byte pipe on the host
+class IUARTPort
+{
+public:
+    struct uart_port_config_t
+    {
+        uart_port_t port_num;
+        int baud_rate;
+        int txd;
+        int rxd;
+        int rx_buffer_size;
+        int event_queue_size; // 0 - no event queue
+    };
+
+    virtual ~IUARTPort() = default;
+
+    virtual esp_err_t open(const uart_port_config_t& config) = 0;
+    virtual esp_err_t close() = 0;
+    // uart_event_t queue, nullptr if opened without one
+    virtual QueueHandle_t getEventQueue() const = 0;
+
+    virtual esp_err_t setBaudRate(int baud_rate) = 0;
+    // UART_PATTERN_DET event and position queue for every pattern character
+    virtual esp_err_t enablePattern(char pattern, int queue_size) = 0;
+    // Position of the oldest detected pattern relative to the read position, -1 if none
+    virtual int popPattern() = 0;
+    // Idle time in symbols after which received bytes are delivered
+    virtual esp_err_t setRxTimeout(uint8_t symbols) = 0;
+
+    // Waits until length bytes are read or timeout expires, returns bytes read or -1
+    virtual int read(void* buffer, size_t length, TickType_t timeout) = 0;
+    virtual int write(const void* data, size_t length) = 0;
+    virtual esp_err_t waitTxDone(TickType_t timeout) = 0;
+    virtual size_t getBufferedLength() = 0;
+    virtual esp_err_t flushInput() = 0;
+};
+
+
+#endif //IUARTPORT_H
@@ -0,0 +1,271 @@
+//
+// Created by stikper on 18.05.25.
+//
+// NEO6M ingestion pipeline on the host: real tasks, queues and driver events over an in-process UART.
+// A synthetic 10 Hz NMEA stream (RMC, VTG, GGA, GSA every epoch, three GSV once per second) is played
+// at 115200 baud, then time-compressed by growing multiples until the pipeline starts losing sentences.
+// Usage: gps_pipeline_bench [--time <seconds per run>] [--max-rate <multiple>]
+//
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GPS/NEO6M.h"
+#include "HostUARTPort.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr int BAUD_RATE = 115200;
+    constexpr double BYTES_PER_SECOND = BAUD_RATE / 10.0; // 8N1
+    constexpr int NAV_RATE_HZ = 10;
+    constexpr int STREAM_SECONDS = 60; // Synthetic stream is looped
+
+    struct Stream
+    {
+        std::string bytes;
+        std::vector<size_t> epochs;    // Offset of every epoch burst
+        std::vector<size_t> sentences; // End offset of every sentence
+    };
+
+    void appendSentence(Stream* stream, const char* body)
+    {
+        uint8_t checksum = 0;
+        for (const char* c = body; *c != '\0'; c++) checksum ^= static_cast<uint8_t>(*c);
+
+        char line[128];
+        snprintf(line, sizeof(line), "$%s*%02X\r\n", body, checksum);
+        stream->bytes += line;
+        stream->sentences.push_back(stream->bytes.size());
+    }
+
+    Stream synthesize()
+    {
+        Stream stream;
+        char body[112];
+
+        for (int epoch = 0; epoch < STREAM_SECONDS * NAV_RATE_HZ; epoch++)
+        {
+            stream.epochs.push_back(stream.bytes.size());
+
+            const int centis = epoch * (100 / NAV_RATE_HZ);
+            char time[16];
+            snprintf(time, sizeof(time), "12%02d%02d.%02d", centis / 6000, centis / 100 % 60, centis % 100);
+            const double lat_min = 45.12345 + epoch * 0.00001;
+            const double lon_min = 22.54321 + epoch * 0.00002;
+
+            snprintf(body, sizeof(body), "GPRMC,%s,A,55%08.5f,N,037%08.5f,E,0.512,54.70,180525,,,A",
+                     time, lat_min, lon_min);
+            appendSentence(&stream, body);
+            appendSentence(&stream, "GPVTG,54.70,T,,M,0.512,N,0.948,K,A");
+            snprintf(body, sizeof(body), "GPGGA,%s,55%08.5f,N,037%08.5f,E,1,08,1.01,152.4,M,14.2,M,,",
+                     time, lat_min, lon_min);
+            appendSentence(&stream, body);
+            appendSentence(&stream, "GPGSA,A,3,04,05,09,12,24,25,29,31,,,,,1.72,1.01,1.39");
+
+            if (epoch % NAV_RATE_HZ == 0)
+            {
+                appendSentence(&stream, "GPGSV,3,1,11,04,40,083,46,05,14,229,38,09,68,269,43,12,22,040,40");
+                appendSentence(&stream, "GPGSV,3,2,11,17,09,315,,24,31,151,44,25,47,201,45,29,18,301,36");
+                appendSentence(&stream, "GPGSV,3,3,11,31,55,099,47,02,03,359,,20,05,170,");
+            }
+        }
+        return stream;
+    }
+
+    // Stream bytes the receiver has sent by the given time at rate x real time,
+    // each epoch burst is sent back to back at the (multiplied) line speed
+    uint64_t bytesDue(const Stream& stream, const double seconds, const double rate)
+    {
+        const double epochs = seconds * NAV_RATE_HZ * rate;
+        const auto epoch = static_cast<uint64_t>(epochs);
+        const size_t count = stream.epochs.size();
+        const size_t index = epoch % count;
+
+        const uint64_t loop = epoch / count * stream.bytes.size();
+        const size_t begin = stream.epochs[index];
+        const size_t end = index + 1 < count ? stream.epochs[index + 1] : stream.bytes.size();
+
+        const double since = (epochs - static_cast<double>(epoch)) / (NAV_RATE_HZ * rate);
+        const auto sent = static_cast<uint64_t>(since * BYTES_PER_SECOND * rate);
+        return loop + begin + (sent < end - begin ? sent : end - begin);
+    }
+
+    uint64_t sentencesIn(const Stream& stream, const uint64_t bytes)
+    {
+        const uint64_t loops = bytes / stream.bytes.size();
+        const size_t rest = bytes % stream.bytes.size();
+
+        size_t complete = 0;
+        while (complete < stream.sentences.size() && stream.sentences[complete] <= rest) complete++;
+        return loops * stream.sentences.size() + complete;
+    }
+
+    double cpuSeconds(const clockid_t clock)
+    {
+        timespec ts{};
+        clock_gettime(clock, &ts);
+        return ts.tv_sec + ts.tv_nsec * 1e-9;
+    }
+
+    const char* modeName(const NEO6M::ingest_mode_t mode)
+    {
+        switch (mode)
+        {
+        case NEO6M::INGEST_PATTERN: return "pattern";
+        case NEO6M::INGEST_STREAM: return "stream";
+        case NEO6M::INGEST_DIRECT: return "direct";
+        }
+        return "?";
+    }
+
+    struct Result
+    {
+        double offered_per_s = 0;
+        double parsed_per_s = 0;
+        uint64_t lost = 0;
+        uint32_t pool_drops = 0;
+        uint64_t ring_drops = 0;
+        uint32_t event_drops = 0;
+        double cpu_us_per_sentence = 0;
+        double cpu_load = 0;
+        LatencyHistogram::Snapshot latency;
+    };
+
+    Result run(const Stream& stream, const NEO6M::ingest_mode_t mode, const double rate, const double seconds)
+    {
+        NEO6M::neo6m_config_t config = NEO6M::defaultConfig();
+        config.ingest_mode = mode;
+        config.configure_receiver = false; // Nothing answers UBX on the pipe
+        config.uart_baud_rate = BAUD_RATE;
+        config.pps_gpio = -1;
+
+        HostUARTPort port;
+        NEO6M neo6m(&port, config);
+        IGPSModule& gps = neo6m;
+        if (gps.start() != ESP_OK)
+        {
+            fprintf(stderr, "Failed to start %s ingestion\n", modeName(mode));
+            exit(1);
+        }
+
+        // Wire side, paced in 1 ms steps
+        std::atomic<double> feeder_cpu{0};
+        uint64_t injected = 0;
+        const double process_cpu = cpuSeconds(CLOCK_PROCESS_CPUTIME_ID);
+        const Clock::time_point start = Clock::now();
+
+        std::thread feeder([&]
+        {
+            const double thread_cpu = cpuSeconds(CLOCK_THREAD_CPUTIME_ID);
+            auto tick = start;
+            while (true)
+            {
+                tick += std::chrono::milliseconds(1);
+                std::this_thread::sleep_until(tick);
+                const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+                const uint64_t due = bytesDue(stream, elapsed < seconds ? elapsed : seconds, rate);
+
+                while (injected < due)
+                {
+                    const size_t offset = injected % stream.bytes.size();
+                    size_t length = stream.bytes.size() - offset;
+                    if (length > due - injected) length = due - injected;
+                    port.inject(stream.bytes.data() + offset, length);
+                    injected += length;
+                }
+                if (elapsed >= seconds) break;
+            }
+            feeder_cpu = cpuSeconds(CLOCK_THREAD_CPUTIME_ID) - thread_cpu;
+        });
+        feeder.join();
+
+        // Let the pipeline drain what is already buffered
+        uint32_t parsed = 0;
+        for (int i = 0; i < 50; i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            const uint32_t now = neo6m.getLatency().total;
+            if (now == parsed && port.getBufferedLength() == 0) break;
+            parsed = now;
+        }
+        const double wall = std::chrono::duration<double>(Clock::now() - start).count();
+        const double cpu = cpuSeconds(CLOCK_PROCESS_CPUTIME_ID) - process_cpu - feeder_cpu;
+
+        Result result;
+        result.latency = neo6m.getLatency();
+        const uint64_t offered = sentencesIn(stream, injected);
+        result.offered_per_s = offered / seconds;
+        result.parsed_per_s = result.latency.total / seconds;
+        result.lost = offered > result.latency.total ? offered - result.latency.total : 0;
+        result.pool_drops = neo6m.getDroppedSentences();
+        const HostUARTPort::Stats stats = port.getStats();
+        result.ring_drops = stats.dropped_bytes;
+        result.event_drops = stats.dropped_events;
+        result.cpu_us_per_sentence = result.latency.total > 0 ? cpu * 1e6 / result.latency.total : 0;
+        result.cpu_load = cpu / wall;
+
+        gps.stop();
+        return result;
+    }
+
+    void print(const NEO6M::ingest_mode_t mode, const double rate, const Result& r)
+    {
+        printf("%-8s %5.0fx %10.0f %10.0f %8llu %6u %9llu %7u %9.2f %6.1f%% %8lld %8lld %8lld\n",
+               modeName(mode), rate, r.offered_per_s, r.parsed_per_s,
+               static_cast<unsigned long long>(r.lost), r.pool_drops,
+               static_cast<unsigned long long>(r.ring_drops), r.event_drops,
+               r.cpu_us_per_sentence, r.cpu_load * 100,
+               static_cast<long long>(r.latency.percentile(50)), static_cast<long long>(r.latency.percentile(99)),
+               static_cast<long long>(r.latency.max_us));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    double seconds = 2;
+    double max_rate = 64;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--time") == 0 && i + 1 < argc)
+            seconds = atof(argv[++i]);
+        else if (strcmp(argv[i], "--max-rate") == 0 && i + 1 < argc)
+            max_rate = atof(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--time <seconds per run>] [--max-rate <multiple>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    const Stream stream = synthesize();
+    printf("Stream: %d Hz, %zu sentences, %.1f bytes/sentence, %d baud line is %.0f%% busy at 1x\n\n",
+           NAV_RATE_HZ, stream.sentences.size(), static_cast<double>(stream.bytes.size()) / stream.sentences.size(),
+           BAUD_RATE, stream.bytes.size() / (STREAM_SECONDS * BYTES_PER_SECOND) * 100);
+    printf("%-8s %6s %10s %10s %8s %6s %9s %7s %9s %7s %8s %8s %8s\n",
+           "mode", "rate", "offered/s", "parsed/s", "lost", "pool", "ring B", "events",
+           "us/sent", "cpu", "p50 us", "p99 us", "max us");
+
+    for (const auto mode : {NEO6M::INGEST_PATTERN, NEO6M::INGEST_STREAM, NEO6M::INGEST_DIRECT})
+    {
+        double sustained = 0;
+        for (double rate = 1; rate <= max_rate; rate *= 4)
+        {
+            const Result result = run(stream, mode, rate, seconds);
+            print(mode, rate, result);
+            if (result.lost == 0) sustained = result.parsed_per_s;
+        }
+        printf("%-8s sustained without loss: %.0f sentences/s\n\n", modeName(mode), sustained);
+    }
+
+    return 0;
+}
@@ -0,0 +1,246 @@
+//
+// Created by stikper on 18.05.25.
+//
+
+#include "HostUARTPort.h"
+
+#include <chrono>
+#include <cstring>
+
+
+HostUARTPort::HostUARTPort()
+{
+    opened = false;
+    eventQueue = nullptr;
+    baud_rate = 0;
+    read_pos = 0;
+    write_pos = 0;
+    pattern_enabled = false;
+    pattern = '\0';
+    pattern_queue_size = 0;
+    stats = {};
+}
+
+HostUARTPort::~HostUARTPort()
+{
+    close();
+}
+
+size_t HostUARTPort::inject(const void* data, const size_t length)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!opened) return 0;
+
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    size_t accepted = 0;
+    stats.received += length;
+
+    // Driver ISR runs once per FIFO fill
+    for (size_t offset = 0; offset < length; offset += FIFO_FULL_THRESHOLD)
+    {
+        const size_t chunk = length - offset < FIFO_FULL_THRESHOLD ? length - offset : FIFO_FULL_THRESHOLD;
+        const size_t space = ring.size() - static_cast<size_t>(write_pos - read_pos);
+        const size_t fit = chunk < space ? chunk : space;
+
+        size_t segment = 0;
+        for (size_t i = 0; i < fit; i++)
+        {
+            const uint8_t byte = bytes[offset + i];
+            ring[write_pos % ring.size()] = byte;
+            write_pos++;
+            segment++;
+
+            if (!pattern_enabled || byte != static_cast<uint8_t>(pattern)) continue;
+            if (patterns.size() < pattern_queue_size)
+                patterns.push_back(write_pos - 1);
+            else
+                stats.dropped_patterns++;
+            postEvent(UART_PATTERN_DET, segment);
+            segment = 0;
+        }
+        if (segment > 0) postEvent(UART_DATA, segment);
+        accepted += fit;
+
+        if (fit < chunk)
+        {
+            stats.dropped_bytes += chunk - fit;
+            postEvent(UART_BUFFER_FULL, 0);
+        }
+    }
+
+    readable.notify_all();
+    return accepted;
+}
+
+void HostUARTPort::postEvent(const uart_event_type_t type, const size_t size)
+{
+    if (eventQueue == nullptr) return;
+
+    const uart_event_t event = {.type = type, .size = size, .timeout_flag = false};
+    if (xQueueSend(eventQueue, &event, 0) != pdTRUE)
+        stats.dropped_events++;
+}
+
+HostUARTPort::Stats HostUARTPort::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+void HostUARTPort::resetStats()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    stats = {};
+}
+
+int HostUARTPort::getBaudRate() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return baud_rate;
+}
+
+esp_err_t HostUARTPort::open(const uart_port_config_t& config)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (opened) return ESP_ERR_INVALID_STATE;
+    if (config.rx_buffer_size <= 0) return ESP_ERR_INVALID_ARG;
+
+    if (config.event_queue_size > 0)
+    {
+        eventQueue = xQueueCreate(config.event_queue_size, sizeof(uart_event_t));
+        if (eventQueue == nullptr) return ESP_ERR_NO_MEM;
+    }
+
+    ring.assign(config.rx_buffer_size, 0);
+    read_pos = 0;
+    write_pos = 0;
+    baud_rate = config.baud_rate;
+    pattern_enabled = false;
+    patterns.clear();
+    opened = true;
+    return ESP_OK;
+}
+
+esp_err_t HostUARTPort::close()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!opened) return ESP_OK;
+
+    opened = false;
+    if (eventQueue != nullptr)
+    {
+        vQueueDelete(eventQueue);
+        eventQueue = nullptr;
+    }
+    readable.notify_all();
+    return ESP_OK;
+}
+
+QueueHandle_t HostUARTPort::getEventQueue() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return eventQueue;
+}
+
+esp_err_t HostUARTPort::setBaudRate(const int baud_rate)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    this->baud_rate = baud_rate;
+    return ESP_OK;
+}
+
+esp_err_t HostUARTPort::enablePattern(const char pattern, const int queue_size)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (queue_size <= 0) return ESP_ERR_INVALID_ARG;
+
+    this->pattern = pattern;
+    pattern_queue_size = queue_size;
+    pattern_enabled = true;
+    patterns.clear();
+    return ESP_OK;
+}
+
+int HostUARTPort::popPattern()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Positions already consumed by plain reads are stale
+    while (!patterns.empty() && patterns.front() < read_pos)
+        patterns.pop_front();
+    if (patterns.empty()) return -1;
+
+    const uint64_t pos = patterns.front();
+    patterns.pop_front();
+    return static_cast<int>(pos - read_pos);
+}
+
+esp_err_t HostUARTPort::setRxTimeout(uint8_t)
+{
+    // Injected bursts are delivered at once, there is no FIFO tail to time out
+    return ESP_OK;
+}
+
+int HostUARTPort::read(void* buffer, const size_t length, const TickType_t timeout)
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!opened) return -1;
+
+    auto* out = static_cast<uint8_t*>(buffer);
+    const Clock::time_point deadline = timeout == portMAX_DELAY
+                                           ? Clock::time_point::max()
+                                           : Clock::now() + std::chrono::milliseconds(
+                                               timeout * 1000 / configTICK_RATE_HZ);
+    size_t done = 0;
+    while (true)
+    {
+        while (done < length && read_pos < write_pos)
+        {
+            const size_t start = read_pos % ring.size();
+            const size_t available = static_cast<size_t>(write_pos - read_pos);
+            size_t run = ring.size() - start;
+            if (run > available) run = available;
+            if (run > length - done) run = length - done;
+
+            memcpy(out + done, &ring[start], run);
+            read_pos += run;
+            done += run;
+        }
+        if (done == length || !opened || Clock::now() >= deadline) break;
+
+        vHostTaskCheckDeleted();
+        const Clock::time_point slice = Clock::now() + std::chrono::milliseconds(10);
+        readable.wait_until(lock, slice < deadline ? slice : deadline);
+    }
+    return static_cast<int>(done);
+}
+
+int HostUARTPort::write(const void*, const size_t length)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!opened) return -1;
+
+    stats.written += length;
+    return static_cast<int>(length);
+}
+
+esp_err_t HostUARTPort::waitTxDone(TickType_t)
+{
+    return ESP_OK;
+}
+
+size_t HostUARTPort::getBufferedLength()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<size_t>(write_pos - read_pos);
+}
+
+esp_err_t HostUARTPort::flushInput()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    read_pos = write_pos;
+    patterns.clear();
+    return ESP_OK;
+}
@@ -0,0 +1,85 @@
+//
+// Created by stikper on 18.05.25.
+//
+
+#ifndef HOSTUARTPORT_H
+#define HOSTUARTPORT_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "UART/IUARTPort.h"
+
+
+// In-process byte pipe behaving like the ESP-IDF UART driver: bytes injected on the wire side land
+// in a bounded RX ring buffer and raise the same events (UART_DATA per hardware FIFO fill,
+// UART_PATTERN_DET with a position queue, UART_BUFFER_FULL when the ring overflows).
+// TX bytes are only counted, there is no receiver to answer them.
+class HostUARTPort final : public IUARTPort
+{
+public:
+    struct Stats
+    {
+        uint64_t received;         // Bytes injected while open
+        uint64_t dropped_bytes;    // RX ring buffer was full
+        uint32_t dropped_events;   // Event queue was full
+        uint32_t dropped_patterns; // Pattern position queue was full
+        uint64_t written;
+    };
+
+    static constexpr size_t FIFO_FULL_THRESHOLD = 120; // Driver default RX FIFO interrupt threshold
+
+private:
+    mutable std::mutex mutex;
+    std::condition_variable readable;
+
+    bool opened;
+    QueueHandle_t eventQueue;
+    int baud_rate;
+
+    std::vector<uint8_t> ring;
+    uint64_t read_pos; // Absolute stream positions
+    uint64_t write_pos;
+
+    bool pattern_enabled;
+    char pattern;
+    size_t pattern_queue_size;
+    std::deque<uint64_t> patterns;
+
+    Stats stats;
+
+public:
+    HostUARTPort();
+    ~HostUARTPort() override;
+
+    // Wire side: bytes arriving on RX in one burst, returns how many fit into the ring buffer
+    size_t inject(const void* data, size_t length);
+
+    Stats getStats() const;
+    void resetStats();
+    int getBaudRate() const;
+
+    esp_err_t open(const uart_port_config_t& config) override;
+    esp_err_t close() override;
+    QueueHandle_t getEventQueue() const override;
+
+    esp_err_t setBaudRate(int baud_rate) override;
+    esp_err_t enablePattern(char pattern, int queue_size) override;
+    int popPattern() override;
+    esp_err_t setRxTimeout(uint8_t symbols) override;
+
+    int read(void* buffer, size_t length, TickType_t timeout) override;
+    int write(const void* data, size_t length) override;
+    esp_err_t waitTxDone(TickType_t timeout) override;
+    size_t getBufferedLength() override;
+    esp_err_t flushInput() override;
+
+private:
+    void postEvent(uart_event_type_t type, size_t size);
+};
+
+
+#endif //HOSTUARTPORT_H
@@ -0,0 +1,214 @@
+//
+// Created by stikper on 18.05.25.
+//
+// FreeRTOS task, queue and semaphore stand-ins on POSIX threads.
+// Blocking calls wait in short slices so a deleted task notices it within one slice.
+//
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct HostTask
+{
+    std::string name;
+    std::thread thread;
+    std::mutex created; // Held until thread is assigned
+    std::atomic<bool> deleted{false};
+};
+
+struct HostQueue
+{
+    std::mutex mutex;
+    std::condition_variable changed;
+    size_t length;
+    size_t item_size;
+    std::vector<uint8_t> storage;
+    size_t head;
+    size_t count;
+};
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr auto WAIT_SLICE = std::chrono::milliseconds(10);
+
+    // Unwinds a deleted task up to its thread entry
+    struct TaskDeleted
+    {
+    };
+
+    thread_local HostTask* current = nullptr;
+
+    const Clock::time_point boot = Clock::now();
+
+    Clock::time_point deadlineOf(const TickType_t wait)
+    {
+        if (wait == portMAX_DELAY) return Clock::time_point::max();
+        return Clock::now() + std::chrono::milliseconds(wait * 1000 / configTICK_RATE_HZ);
+    }
+
+    template <typename Ready>
+    bool waitFor(std::unique_lock<std::mutex>& lock, std::condition_variable& changed, const TickType_t wait,
+                 Ready ready)
+    {
+        if (ready()) return true;
+        if (wait == 0) return false;
+
+        const Clock::time_point deadline = deadlineOf(wait);
+        while (true)
+        {
+            vHostTaskCheckDeleted();
+            const Clock::time_point slice = Clock::now() + WAIT_SLICE;
+            changed.wait_until(lock, slice < deadline ? slice : deadline);
+            if (ready()) return true;
+            if (Clock::now() >= deadline) return false;
+        }
+    }
+}
+
+void vHostTaskCheckDeleted()
+{
+    if (current != nullptr && current->deleted.load(std::memory_order_acquire))
+        throw TaskDeleted();
+}
+
+BaseType_t xTaskCreate(const TaskFunction_t function, const char* name, uint32_t, void* param, UBaseType_t,
+                       TaskHandle_t* handle)
+{
+    auto* task = new HostTask();
+    task->name = name != nullptr ? name : "";
+
+    {
+        std::lock_guard<std::mutex> created(task->created);
+        task->thread = std::thread([task, function, param]
+        {
+            {
+                std::lock_guard<std::mutex> assigned(task->created);
+            }
+            current = task;
+            try
+            {
+                function(param);
+            }
+            catch (const TaskDeleted&)
+            {
+            }
+        });
+    }
+
+    if (handle != nullptr) *handle = task;
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task == nullptr || task == current)
+    {
+        // Nobody joins a task that deletes itself, its record stays allocated
+        current->deleted.store(true, std::memory_order_release);
+        current->thread.detach();
+        throw TaskDeleted();
+    }
+
+    task->deleted.store(true, std::memory_order_release);
+    if (task->thread.joinable()) task->thread.join();
+    delete task;
+}
+
+void vTaskDelay(const TickType_t ticks)
+{
+    if (ticks == 0)
+    {
+        vHostTaskCheckDeleted();
+        std::this_thread::yield();
+        return;
+    }
+
+    const Clock::time_point deadline = deadlineOf(ticks);
+    while (true)
+    {
+        vHostTaskCheckDeleted();
+        const Clock::time_point now = Clock::now();
+        if (now >= deadline) return;
+        std::this_thread::sleep_until(now + WAIT_SLICE < deadline ? now + WAIT_SLICE : deadline);
+    }
+}
+
+TickType_t xTaskGetTickCount()
+{
+    using namespace std::chrono;
+    const auto ms = duration_cast<milliseconds>(Clock::now() - boot).count();
+    return static_cast<TickType_t>(ms * configTICK_RATE_HZ / 1000);
+}
+
+QueueHandle_t xQueueCreate(const UBaseType_t length, const UBaseType_t item_size)
+{
+    if (length == 0) return nullptr;
+
+    auto* queue = new HostQueue();
+    queue->length = length;
+    queue->item_size = item_size;
+    queue->storage.resize(static_cast<size_t>(length) * item_size);
+    queue->head = 0;
+    queue->count = 0;
+    return queue;
+}
+
+void vQueueDelete(const QueueHandle_t queue)
+{
+    delete queue;
+}
+
+BaseType_t xQueueSend(const QueueHandle_t queue, const void* item, const TickType_t wait)
+{
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if (!waitFor(lock, queue->changed, wait, [queue] { return queue->count < queue->length; }))
+        return pdFALSE;
+
+    const size_t tail = (queue->head + queue->count) % queue->length;
+    if (queue->item_size > 0)
+        memcpy(&queue->storage[tail * queue->item_size], item, queue->item_size);
+    queue->count++;
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(const QueueHandle_t queue, void* buffer, const TickType_t wait)
+{
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if (!waitFor(lock, queue->changed, wait, [queue] { return queue->count > 0; }))
+        return pdFALSE;
+
+    if (queue->item_size > 0)
+        memcpy(buffer, &queue->storage[queue->head * queue->item_size], queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReset(const QueueHandle_t queue)
+{
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    queue->head = 0;
+    queue->count = 0;
+    queue->changed.notify_all();
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t queue)
+{
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    return static_cast<UBaseType_t>(queue->count);
+}
@@ -0,0 +1,60 @@
+//
+// Host stand-in for ESP-IDF driver/gpio.h
+// There are no pins on the host, every call reports ESP_ERR_NOT_SUPPORTED
+//
+
+#ifndef HOST_GPIO_H
+#define HOST_GPIO_H
+
+#include <cstdint>
+
+#include "esp_err.h"
+#include "soc/gpio_num.h"
+
+typedef enum
+{
+    GPIO_MODE_DISABLE,
+    GPIO_MODE_INPUT,
+    GPIO_MODE_OUTPUT
+} gpio_mode_t;
+
+typedef enum
+{
+    GPIO_PULLUP_DISABLE,
+    GPIO_PULLUP_ENABLE
+} gpio_pullup_t;
+
+typedef enum
+{
+    GPIO_PULLDOWN_DISABLE,
+    GPIO_PULLDOWN_ENABLE
+} gpio_pulldown_t;
+
+typedef enum
+{
+    GPIO_INTR_DISABLE,
+    GPIO_INTR_POSEDGE,
+    GPIO_INTR_NEGEDGE,
+    GPIO_INTR_ANYEDGE
+} gpio_int_type_t;
+
+typedef struct
+{
+    uint64_t pin_bit_mask;
+    gpio_mode_t mode;
+    gpio_pullup_t pull_up_en;
+    gpio_pulldown_t pull_down_en;
+    gpio_int_type_t intr_type;
+} gpio_config_t;
+
+typedef void (*gpio_isr_t)(void*);
+
+#define ESP_INTR_FLAG_IRAM (1 << 10)
+
+inline esp_err_t gpio_config(const gpio_config_t*) { return ESP_ERR_NOT_SUPPORTED; }
+inline esp_err_t gpio_reset_pin(gpio_num_t) { return ESP_ERR_NOT_SUPPORTED; }
+inline esp_err_t gpio_install_isr_service(int) { return ESP_ERR_NOT_SUPPORTED; }
+inline esp_err_t gpio_isr_handler_add(gpio_num_t, gpio_isr_t, void*) { return ESP_ERR_NOT_SUPPORTED; }
+inline esp_err_t gpio_isr_handler_remove(gpio_num_t) { return ESP_ERR_NOT_SUPPORTED; }
+
+#endif //HOST_GPIO_H
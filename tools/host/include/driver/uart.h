@@ -0,0 +1,39 @@
+//
+// Host stand-in for ESP-IDF driver/uart.h, event types only.
+// The driver itself is replaced by a port implementation, see host/HostUARTPort.h
+//
+
+#ifndef HOST_UART_H
+#define HOST_UART_H
+
+#include <cstddef>
+
+#include "hal/uart_types.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#define UART_PIN_NO_CHANGE (-1)
+
+typedef enum
+{
+    UART_DATA,
+    UART_BREAK,
+    UART_BUFFER_FULL,
+    UART_FIFO_OVF,
+    UART_FRAME_ERR,
+    UART_PARITY_ERR,
+    UART_DATA_BREAK,
+    UART_PATTERN_DET,
+    UART_EVENT_MAX
+} uart_event_type_t;
+
+typedef struct
+{
+    uart_event_type_t type;
+    size_t size;
+    bool timeout_flag;
+} uart_event_t;
+
+#endif //HOST_UART_H
@@ -0,0 +1,10 @@
+//
+// Host stand-in for ESP-IDF esp_attr.h
+//
+
+#ifndef HOST_ESP_ATTR_H
+#define HOST_ESP_ATTR_H
+
+#define IRAM_ATTR
+
+#endif //HOST_ESP_ATTR_H
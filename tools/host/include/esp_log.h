@@ -0,0 +1,36 @@
+//
+// Host stand-in for ESP-IDF esp_log.h
+// Only warnings and errors are printed, benchmarks must not pay for logging
+//
+
+#ifndef HOST_ESP_LOG_H
+#define HOST_ESP_LOG_H
+
+#include <cstdio>
+
+#include "esp_err.h"
+
+typedef enum
+{
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+inline void esp_log_level_set(const char*, esp_log_level_t) {}
+
+#define HOST_LOG(letter, tag, format, ...) fprintf(stderr, letter " (%s) " format "\n", tag, ##__VA_ARGS__)
+
+#define ESP_LOGE(tag, format, ...) HOST_LOG("E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) HOST_LOG("W", tag, format, ##__VA_ARGS__)
+// Arguments stay used and format checked, the call is compiled out
+#define HOST_LOG_OFF(tag, format, ...) do { if (0) HOST_LOG("", tag, format, ##__VA_ARGS__); } while (0)
+
+#define ESP_LOGI(tag, format, ...) HOST_LOG_OFF(tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) HOST_LOG_OFF(tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) HOST_LOG_OFF(tag, format, ##__VA_ARGS__)
+
+#endif //HOST_ESP_LOG_H
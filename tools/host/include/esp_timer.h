@@ -0,0 +1,17 @@
+//
+// Host stand-in for ESP-IDF esp_timer.h
+//
+
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+
+#include <chrono>
+#include <cstdint>
+
+inline int64_t esp_timer_get_time()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+#endif //HOST_ESP_TIMER_H
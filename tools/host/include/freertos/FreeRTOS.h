@@ -0,0 +1,34 @@
+//
+// Host stand-in for FreeRTOS.h
+// Primitives are implemented on POSIX threads in host/freertos.cpp, one tick is one millisecond
+//
+
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+#include <cstdint>
+
+#include "esp_err.h"
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+
+#define configTICK_RATE_HZ 1000
+#define portMAX_DELAY static_cast<TickType_t>(0xFFFFFFFF)
+#define pdMS_TO_TICKS(ms) static_cast<TickType_t>(static_cast<uint64_t>(ms) * configTICK_RATE_HZ / 1000)
+
+// Comes with newlib's sys/cdefs.h on target, glibc only has it for C
+#ifndef _Noreturn
+#define _Noreturn [[noreturn]]
+#endif
+
+typedef struct HostQueue* QueueHandle_t;
+typedef struct HostTask* TaskHandle_t;
+
+#endif //HOST_FREERTOS_H
@@ -0,0 +1,22 @@
+//
+// Host stand-in for FreeRTOS queue.h
+//
+
+#ifndef HOST_QUEUE_H
+#define HOST_QUEUE_H
+
+#include "FreeRTOS.h"
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+void vQueueDelete(QueueHandle_t queue);
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t wait);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* buffer, TickType_t wait);
+BaseType_t xQueueReset(QueueHandle_t queue);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+
+inline BaseType_t xQueueSendToBack(QueueHandle_t queue, const void* item, const TickType_t wait)
+{
+    return xQueueSend(queue, item, wait);
+}
+
+#endif //HOST_QUEUE_H
@@ -0,0 +1,41 @@
+//
+// Host stand-in for FreeRTOS semphr.h
+// As in FreeRTOS, a semaphore is a queue of empty items, a mutex starts with one given
+//
+
+#ifndef HOST_SEMPHR_H
+#define HOST_SEMPHR_H
+
+#include "FreeRTOS.h"
+#include "queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateBinary()
+{
+    return xQueueCreate(1, 0);
+}
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    const SemaphoreHandle_t mutex = xQueueCreate(1, 0);
+    if (mutex != nullptr) xQueueSend(mutex, nullptr, 0);
+    return mutex;
+}
+
+inline BaseType_t xSemaphoreTake(const SemaphoreHandle_t semaphore, const TickType_t wait)
+{
+    return xQueueReceive(semaphore, nullptr, wait);
+}
+
+inline BaseType_t xSemaphoreGive(const SemaphoreHandle_t semaphore)
+{
+    return xQueueSend(semaphore, nullptr, 0);
+}
+
+inline void vSemaphoreDelete(const SemaphoreHandle_t semaphore)
+{
+    vQueueDelete(semaphore);
+}
+
+#endif //HOST_SEMPHR_H
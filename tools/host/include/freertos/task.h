@@ -0,0 +1,25 @@
+//
+// Host stand-in for FreeRTOS task.h
+// Tasks are POSIX threads, priorities are ignored. Deleting another task is cooperative:
+// it stops at its next blocking call, so host tasks must block on these primitives.
+//
+
+#ifndef HOST_TASK_H
+#define HOST_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void*);
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stack_depth, void* param,
+                       UBaseType_t priority, TaskHandle_t* handle);
+// nullptr deletes the calling task, otherwise waits until the task has stopped
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount();
+
+// Host only: ends the calling task here if it has been deleted.
+// Blocking code outside these primitives calls it while it waits
+void vHostTaskCheckDeleted();
+
+#endif //HOST_TASK_H
@@ -0,0 +1,14 @@
+//
+// Host stand-in for ESP-IDF hal/uart_types.h
+//
+
+#ifndef HOST_UART_TYPES_H
+#define HOST_UART_TYPES_H
+
+typedef int uart_port_t;
+
+#define UART_NUM_0 0
+#define UART_NUM_1 1
+#define UART_NUM_2 2
+
+#endif //HOST_UART_TYPES_H
@@ -0,0 +1,23 @@
+//
+// Host stand-in for the generated sdkconfig.h, Kconfig.projbuild defaults
+//
+
+#ifndef HOST_SDKCONFIG_H
+#define HOST_SDKCONFIG_H
+
+#define CONFIG_GPS_UART_PORT_NUM 2
+#define CONFIG_GPS_UART_BAUD_RATE 9600
+#define CONFIG_GPS_UART_TARGET_BAUD_RATE 115200
+#define CONFIG_GPS_NAV_RATE_HZ 5
+#define CONFIG_GPS_UART_RXD 16
+#define CONFIG_GPS_UART_TXD 17
+#define CONFIG_GPS_PPS_GPIO -1
+#define CONFIG_GPS_UART_BUFFER_SIZE 1024
+#define CONFIG_GPS_QUEUE_SIZE 16
+#define CONFIG_GPS_TASK_STACK_SIZE 4096
+#define CONFIG_GPS_TASK_PRIORITY 12
+#define CONFIG_GPS_BUFFER_SIZE 10
+#define CONFIG_GPS_CHECKSUM 1
+#define CONFIG_IMU_INT_GPIO -1
+
+#endif //HOST_SDKCONFIG_H
@@ -0,0 +1,15 @@
+//
+// Host stand-in for ESP-IDF soc/gpio_num.h
+//
+
+#ifndef HOST_GPIO_NUM_H
+#define HOST_GPIO_NUM_H
+
+typedef enum
+{
+    GPIO_NUM_NC = -1,
+    GPIO_NUM_0 = 0,
+    GPIO_NUM_MAX = 40
+} gpio_num_t;
+
+#endif //HOST_GPIO_NUM_H
@@ -0,0 +1,190 @@
+//
+// Created by stikper on 16.06.25.
+//
+// IMUConverter host check and microbenchmark.
+// Usage: imu_convert_bench [--time <seconds per case>]
+// Every full scale setting, and one calibration correction, is converted through the vector path,
+// the scalar path and the old per-sample formula. The paths must agree, otherwise the exit code is 1.
+//
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "IMU/IMUConverter.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr size_t RECORDS = 1024;
+
+    volatile float sink;
+
+    // Conversion MPU6050::publishSample did per sample before the batch kernel
+    void convertLegacy(const uint8_t* records, const size_t count, const uint8_t accel_scale,
+                       const uint8_t gyro_scale, float* out)
+    {
+        for (size_t r = 0; r < count; r++)
+        {
+            const uint8_t* record = records + r * IMUConverter::RECORD_SIZE;
+            float* si = out + r * IMUConverter::CHANNELS;
+
+            int16_t raw[IMUConverter::CHANNELS];
+            for (size_t i = 0; i < IMUConverter::CHANNELS; i++)
+                raw[i] = static_cast<int16_t>(record[2 * i] << 8 | record[2 * i + 1]);
+
+            const float accel_div = 16384.0f / powf(2.0f, accel_scale);
+            const float gyro_div = 131.0f / powf(2.0f, gyro_scale);
+            for (size_t i = 0; i < 3; i++)
+            {
+                si[IMUConverter::ACCEL + i] = static_cast<float>(raw[IMUConverter::ACCEL + i]) / accel_div * 9.81f;
+                si[IMUConverter::GYRO + i] = static_cast<float>(raw[IMUConverter::GYRO + i]) / gyro_div;
+            }
+            si[IMUConverter::TEMP] = static_cast<float>(raw[IMUConverter::TEMP]) / 340.0f + 36.53f;
+        }
+    }
+
+    // Largest difference relative to the value, absolute near zero
+    double maxError(const std::vector<float>& a, const std::vector<float>& b)
+    {
+        double worst = 0;
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            const double diff = std::fabs(static_cast<double>(a[i]) - b[i]);
+            const double magnitude = std::fabs(static_cast<double>(b[i]));
+            const double error = magnitude > 1.0 ? diff / magnitude : diff;
+            if (error > worst) worst = error;
+        }
+        return worst;
+    }
+
+    template <typename Body>
+    double measure(const double seconds, Body body)
+    {
+        size_t passes = 0;
+        const auto start = Clock::now();
+        auto now = start;
+        do
+        {
+            body();
+            passes++;
+            now = Clock::now();
+        }
+        while (std::chrono::duration<double>(now - start).count() < seconds);
+
+        const double ns = std::chrono::duration<double, std::nano>(now - start).count();
+        return ns / static_cast<double>(passes * RECORDS);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    double seconds = 0.2;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--time") == 0 && i + 1 < argc)
+            seconds = atof(argv[++i]);
+    }
+
+    // Raw records cover the full int16 range including both ends
+    std::vector<uint8_t> records(RECORDS * IMUConverter::RECORD_SIZE);
+    std::mt19937 rng(6050);
+    for (auto& byte : records) byte = static_cast<uint8_t>(rng());
+    records[0] = 0x80;
+    records[1] = 0x00;
+    records[2] = 0x7F;
+    records[3] = 0xFF;
+
+    std::vector<float> vector_out(RECORDS * IMUConverter::CHANNELS);
+    std::vector<float> scalar_out(vector_out.size());
+    std::vector<float> legacy_out(vector_out.size());
+
+    printf("Vector path: %s, %zu records per pass\n\n", IMUConverter::simdPath(), RECORDS);
+    printf("%-8s %-6s %12s %12s %12s %12s %12s\n",
+           "scales", "burst", "vector ns", "scalar ns", "legacy ns", "vec/scalar", "vec/legacy");
+
+    bool failed = false;
+    IMUConverter converter;
+    for (uint8_t scale = 0; scale < 4; scale++)
+    {
+        converter.setScales(scale, scale);
+
+        // Burst lengths that end on and off the 4-record vector block
+        for (const size_t burst : {1, 7, 32})
+        {
+            const size_t bursts = RECORDS / burst;
+            const size_t used = bursts * burst;
+            auto runVector = [&]
+            {
+                for (size_t b = 0; b < bursts; b++)
+                    converter.convert(records.data() + b * burst * IMUConverter::RECORD_SIZE, burst,
+                                      vector_out.data() + b * burst * IMUConverter::CHANNELS);
+            };
+            auto runScalar = [&]
+            {
+                for (size_t b = 0; b < bursts; b++)
+                    converter.convertScalar(records.data() + b * burst * IMUConverter::RECORD_SIZE, burst,
+                                            scalar_out.data() + b * burst * IMUConverter::CHANNELS);
+            };
+
+            runVector();
+            runScalar();
+            convertLegacy(records.data(), used, scale, scale, legacy_out.data());
+            vector_out.resize(used * IMUConverter::CHANNELS);
+            scalar_out.resize(vector_out.size());
+            legacy_out.resize(vector_out.size());
+
+            // Same multiply and add in both paths, only FMA contraction of the scalar loop may differ
+            const double vector_error = maxError(vector_out, scalar_out);
+            const double legacy_error = maxError(vector_out, legacy_out);
+            if (vector_error > 1e-6 || legacy_error > 1e-5)
+            {
+                fprintf(stderr, "Scale %u burst %zu: vector/scalar error %g, vector/legacy error %g\n",
+                        scale, burst, vector_error, legacy_error);
+                failed = true;
+            }
+
+            const double vector_ns = measure(seconds, [&] { runVector(); sink = vector_out[0]; });
+            const double scalar_ns = measure(seconds, [&] { runScalar(); sink = scalar_out[0]; });
+            const double legacy_ns = measure(seconds, [&]
+            {
+                convertLegacy(records.data(), used, scale, scale, legacy_out.data());
+                sink = legacy_out[0];
+            });
+
+            printf("%u/%-6u %-6zu %12.2f %12.2f %12.2f %12.2f %12.2f\n",
+                   scale, scale, burst, vector_ns, scalar_ns, legacy_ns, scalar_ns / vector_ns, legacy_ns / vector_ns);
+
+            vector_out.resize(RECORDS * IMUConverter::CHANNELS);
+            scalar_out.resize(vector_out.size());
+            legacy_out.resize(vector_out.size());
+        }
+    }
+
+    // Calibration folded into the factors goes through the same kernel
+    const float gain[IMUConverter::CHANNELS] = {1.01f, 0.99f, 1.002f, 1.0f, 1.0f, 1.0f, 1.0f};
+    const float bias[IMUConverter::CHANNELS] = {0.12f, -0.3f, 0.05f, 0.0f, 1.7f, -0.8f, 0.25f};
+    converter.setScales(3, 3);
+    converter.setCorrection(gain, bias);
+    converter.convert(records.data(), RECORDS, vector_out.data());
+    converter.convertScalar(records.data(), RECORDS, scalar_out.data());
+    convertLegacy(records.data(), RECORDS, 3, 3, legacy_out.data());
+    for (size_t i = 0; i < legacy_out.size(); i++)
+    {
+        const size_t channel = i % IMUConverter::CHANNELS;
+        legacy_out[i] = (legacy_out[i] - bias[channel]) * gain[channel];
+    }
+    const double corrected_error = maxError(vector_out, scalar_out);
+    const double reference_error = maxError(vector_out, legacy_out);
+    printf("\ncorrected: vector/scalar error %g, vector/reference error %g\n", corrected_error, reference_error);
+    if (corrected_error > 1e-6 || reference_error > 1e-5) failed = true;
+
+    printf("\n%s\n", failed ? "MISMATCH" : "Paths agree");
+    return failed ? 1 : 0;
+}
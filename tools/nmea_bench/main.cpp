@@ -0,0 +1,201 @@
+//
+// Created by stikper on 09.04.25.
+//
+// NMEAParser / NMEAStream host microbenchmark.
+// Usage: nmea_bench [--time <seconds per group>] [corpus.nmea ...]
+// Without files every *.nmea from the bundled corpus directory is used.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "GPS/NMEAParser.h"
+#include "GPS/NMEAStream.h"
+
+// Every heap allocation made by the process is counted
+static size_t allocations = 0;
+
+void* operator new(const std::size_t size)
+{
+    allocations++;
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace
+{
+    using GPSData = IGPSModule::GPSData;
+    using Clock = std::chrono::steady_clock;
+
+    struct Result
+    {
+        std::string name;
+        size_t sentences = 0;
+        double ns_per_sentence = 0;
+        double allocs_per_sentence = 0;
+    };
+
+    volatile int64_t sink;
+
+    void consume(const GPSData& data)
+    {
+        sink = sink + data.checksum + data.valid + data.satellites + data.lat_e7;
+    }
+
+    bool loadCorpus(const std::string& path, std::vector<std::string>* lines)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+
+        std::string line;
+        while (std::getline(file, line))
+        {
+            while (!line.empty() && (line.back() == '\r' || line.back() == '\n')) line.pop_back();
+            if (line.empty() || line[0] == '#') continue;
+            lines->push_back(line + "\r\n");
+        }
+        return true;
+    }
+
+    // Sentences are grouped by type, corrupted ones get a group of their own
+    std::string groupName(const std::string& line)
+    {
+        const GPSData data = NMEAParser::parse(line);
+        if (!data.checksum) return "bad checksum";
+        if (data.parse_error) return std::string(NMEASentence::name(data.type)) + " (error)";
+        return NMEASentence::name(data.type);
+    }
+
+    template <typename Body>
+    Result measure(const std::string& name, const size_t sentences, const double seconds, Body body)
+    {
+        Result result;
+        result.name = name;
+        result.sentences = sentences;
+
+        // Warm-up pass also counts allocations
+        const size_t allocs_before = allocations;
+        body();
+        result.allocs_per_sentence = static_cast<double>(allocations - allocs_before) / sentences;
+
+        size_t passes = 0;
+        const auto start = Clock::now();
+        auto now = start;
+        do
+        {
+            body();
+            passes++;
+            now = Clock::now();
+        }
+        while (std::chrono::duration<double>(now - start).count() < seconds);
+
+        const double ns = std::chrono::duration<double, std::nano>(now - start).count();
+        result.ns_per_sentence = ns / static_cast<double>(passes * sentences);
+        return result;
+    }
+
+    void print(const Result& r)
+    {
+        printf("%-16s %9zu %12.1f %14.0f %12.2f\n",
+               r.name.c_str(), r.sentences, r.ns_per_sentence, 1e9 / r.ns_per_sentence, r.allocs_per_sentence);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    double seconds = 0.2;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--time") == 0 && i + 1 < argc)
+            seconds = atof(argv[++i]);
+        else
+            files.emplace_back(argv[i]);
+    }
+
+    if (files.empty())
+    {
+        for (const auto& entry : std::filesystem::directory_iterator(NMEA_BENCH_CORPUS_DIR))
+            if (entry.path().extension() == ".nmea") files.push_back(entry.path().string());
+        std::sort(files.begin(), files.end());
+    }
+
+    std::vector<std::string> lines;
+    for (const auto& file : files)
+    {
+        if (!loadCorpus(file, &lines))
+        {
+            fprintf(stderr, "Failed to read %s\n", file.c_str());
+            return 1;
+        }
+    }
+    if (lines.empty())
+    {
+        fprintf(stderr, "Corpus is empty\n");
+        return 1;
+    }
+
+    std::map<std::string, std::vector<std::string>> groups;
+    for (const auto& line : lines)
+        groups[groupName(line)].push_back(line);
+
+    printf("Corpus: %zu sentences from %zu file(s)\n\n", lines.size(), files.size());
+    printf("%-16s %9s %12s %14s %12s\n", "type", "sentences", "ns/sentence", "sentences/s", "allocs/sent");
+
+    // NMEAParser::parse over complete lines
+    for (const auto& [name, group] : groups)
+    {
+        print(measure(name, group.size(), seconds, [&group]
+        {
+            for (const auto& line : group) consume(NMEAParser::parse(line));
+        }));
+    }
+
+    print(measure("parse (all)", lines.size(), seconds, [&lines]
+    {
+        for (const auto& line : lines) consume(NMEAParser::parse(line));
+    }));
+
+    // NMEAStream over the raw byte stream, as it is fed from the UART
+    std::string stream;
+    for (const auto& line : lines) stream += line;
+
+    NMEAStream decoder;
+    print(measure("stream (all)", lines.size(), seconds, [&stream, &decoder]
+    {
+        GPSData data;
+        for (const char c : stream)
+            if (decoder.feed(c, &data)) consume(data);
+    }));
+
+    printf("\nstream: %.1f bytes/sentence, %.1f ns/byte\n",
+           static_cast<double>(stream.size()) / lines.size(),
+           measure("", lines.size(), seconds, [&stream, &decoder]
+           {
+               GPSData data;
+               for (const char c : stream)
+                   if (decoder.feed(c, &data)) consume(data);
+           }).ns_per_sentence * lines.size() / stream.size());
+
+    return 0;
+}